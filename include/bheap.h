@@ -29,6 +29,20 @@ typedef struct {
  */
 bool bh_init(BHeap *bh, COMPARE_FUNC compare_func);
 
+/**
+ * Initialize the binary heap data structure with the items of an array. The heap is built bottom-up in linear time,
+ * which is faster than inserting the items one by one. The array is copied, so it is not modified. Note that NULL
+ * elements cannot be inserted in the heap.
+ *
+ * @param bh Pointer to the binary heap data structure.
+ * @param compare_func Function used to compare the items.
+ * @param items The items of the heap.
+ * @param n The number of items.
+ * @return true if the data structure was initialized successfully, false otherwise, in which case the heap must not be
+ * used or destroyed.
+ */
+bool bh_init_from_array(BHeap *bh, COMPARE_FUNC compare_func, void **items, size_t n);
+
 /**
  * Frees resources associated with the binary heap data structure.
  *
@@ -52,6 +66,15 @@ bool bh_is_empty(BHeap *bh);
  */
 size_t bh_size(BHeap *bh);
 
+/**
+ * Make sure that the heap has room for a number of items, so that inserting them does not resize the heap.
+ *
+ * @param bh Pointer to the binary heap data structure.
+ * @param capacity The number of items.
+ * @return true if the heap has room for the items, false if the memory could not be allocated.
+ */
+bool bh_reserve(BHeap *bh, size_t capacity);
+
 /**
  * Insert an element to the heap. Note that NULL elements cannot be inserted in the heap.
  *
@@ -61,6 +84,18 @@ size_t bh_size(BHeap *bh);
  */
 bool bh_insert(BHeap *bh, void *item);
 
+/**
+ * Insert the elements of an array to the heap. The elements are appended to the heap, which is then rebuilt bottom-up
+ * if the batch is at least as big as the heap, since that is cheaper than moving each element to its position. Note
+ * that NULL elements cannot be inserted in the heap.
+ *
+ * @param bh Pointer to the binary heap data structure.
+ * @param items The items to be inserted to the heap.
+ * @param n The number of items.
+ * @return true if the elements were added successfully, false otherwise, in which case none of them was added.
+ */
+bool bh_insert_batch(BHeap *bh, void **items, size_t n);
+
 /**
  * Remove and return the minimum element from the heap.
  *
@@ -1,6 +1,78 @@
 #ifndef _COMMON_H
 #define _COMMON_H
 
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// No internal checks are done
+#define CHECK_LEVEL_NONE 0
+// Only the checks that take constant time are done
+#define CHECK_LEVEL_CHEAP 1
+// The checks that take constant time are done, and the full validations are done on a sample of the calls
+#define CHECK_LEVEL_SAMPLED 2
+// All the checks and the full validations are done
+#define CHECK_LEVEL_FULL 3
+
+// The level of the internal checks. Builds with NDEBUG do no checks by default, and the other builds do sampled checks.
+#ifndef CHECK_LEVEL
+#ifdef NDEBUG
+#define CHECK_LEVEL CHECK_LEVEL_NONE
+#else
+#define CHECK_LEVEL CHECK_LEVEL_SAMPLED
+#endif
+#endif
+
+// One in this many calls do the sampled full validations
+#define CHECK_SAMPLE_PERIOD 64
+
+/**
+ * Report a failed check and abort the program.
+ */
+#define CHECK_FAIL(expr) \
+    (fprintf(stderr, "%s:%d: %s: Check `%s' failed.\n", __FILE__, __LINE__, __func__, #expr), abort())
+
+/**
+ * Check an expression that takes constant time.
+ */
+#if CHECK_LEVEL >= CHECK_LEVEL_CHEAP
+#define CHECK(expr) ((expr) ? (void) 0 : CHECK_FAIL(expr))
+#else
+#define CHECK(expr) ((void) sizeof((expr) ? 1 : 0))
+#endif
+
+/**
+ * Check an expression that does a full validation, on a sample of the calls.
+ */
+#if CHECK_LEVEL >= CHECK_LEVEL_FULL
+#define CHECK_SAMPLED(expr) ((expr) ? (void) 0 : CHECK_FAIL(expr))
+#elif CHECK_LEVEL >= CHECK_LEVEL_SAMPLED
+#define CHECK_SAMPLED(expr) ((!check_sample() || (expr)) ? (void) 0 : CHECK_FAIL(expr))
+#else
+#define CHECK_SAMPLED(expr) ((void) sizeof((expr) ? 1 : 0))
+#endif
+
+/**
+ * Check an expression that does a full validation, on every call. Used for the validations that are too expensive to
+ * be sampled, like the invariants of the loops.
+ */
+#if CHECK_LEVEL >= CHECK_LEVEL_FULL
+#define CHECK_FULL(expr) ((expr) ? (void) 0 : CHECK_FAIL(expr))
+#else
+#define CHECK_FULL(expr) ((void) sizeof((expr) ? 1 : 0))
+#endif
+
+/**
+ * Decide if the sampled validations are done on this call. One in CHECK_SAMPLE_PERIOD calls of each thread is sampled.
+ *
+ * @return true if the validations are done.
+ */
+static inline bool check_sample(void) {
+    static _Thread_local unsigned long counter;
+
+    return counter++ % CHECK_SAMPLE_PERIOD == 0;
+}
+
 /**
  * Prototype for a function that compares two elements.
  *
@@ -0,0 +1,89 @@
+#ifndef _D_HEAP_H
+#define _D_HEAP_H
+
+#include "common.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// The maximum arity of the d-ary heap, for which the children of a node fill a cache line
+#define DH_MAX_ARITY 8
+
+/**
+ * A d-ary heap data structure. Each node has up to d children, which are stored next to each other in the same cache
+ * line, so the heap has fewer levels than a binary heap and each level of a sift down touches one cache line.
+ */
+typedef struct {
+    /** The heap items. The root is stored at index d - 1, so that the children of each node are aligned. */
+    void **items;
+    /** The heap capacity. */
+    size_t capacity;
+    /** The heap size. */
+    size_t size;
+    /** The number of children of each node. */
+    size_t arity;
+    /** The base 2 logarithm of the arity. */
+    unsigned shift;
+    /** The comparison function. */
+    COMPARE_FUNC compare;
+} DHeap;
+
+/**
+ * Initialize the d-ary heap data structure.
+ *
+ * @param dh Pointer to the d-ary heap data structure.
+ * @param compare_func Function used to compare the items.
+ * @param arity The number of children of each node, which must be 2, 4 or 8.
+ * @return true if the data structure was initialized successfully, false otherwise.
+ */
+bool dh_init(DHeap *dh, COMPARE_FUNC compare_func, size_t arity);
+
+/**
+ * Frees resources associated with the d-ary heap data structure.
+ *
+ * @param dh Pointer to the d-ary heap data structure to be freed.
+ */
+void dh_destroy(DHeap *dh);
+
+/**
+ * Check if the d-ary heap contains any elements.
+ *
+ * @param dh Pointer to the d-ary heap data structure.
+ * @return true if the heap contains elements, false otherwise.
+ */
+bool dh_is_empty(DHeap *dh);
+
+/**
+ * Return the size of the d-ary heap.
+ *
+ * @param dh Pointer to the d-ary heap data structure.
+ * @return The size of the d-ary heap.
+ */
+size_t dh_size(DHeap *dh);
+
+/**
+ * Insert an element to the heap. Note that NULL elements cannot be inserted in the heap.
+ *
+ * @param dh Pointer to the d-ary heap data structure.
+ * @param item Pointer to the item to be inserted to the heap.
+ * @return true if the element was added successfully, false otherwise.
+ */
+bool dh_insert(DHeap *dh, void *item);
+
+/**
+ * Remove and return the minimum element from the heap.
+ *
+ * @param dh Pointer to the d-ary heap data structure.
+ * @return The minimum element contained in the heap, or NULL if the heap is empty.
+ */
+void *dh_remove_min(DHeap *dh);
+
+/**
+ * Return the minimum element contained in the heap, or NULL if the heap is empty.
+ *
+ * @param dh Pointer to the d-ary heap data structure.
+ * @return The minimum element contained in the heap, or NULL if the heap is empty.
+ */
+void *dh_peek(DHeap *dh);
+
+#endif // _D_HEAP_H
@@ -0,0 +1,53 @@
+#ifndef _EXTERNAL_SORT_H
+#define _EXTERNAL_SORT_H
+
+#include "common.h"
+#include "sorting.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * The options of an external sort.
+ */
+typedef struct {
+    /** The number of bytes of memory used to sort the runs and to buffer the merge. Zero means the default. */
+    size_t memory;
+    /** The directory where the runs are spilled, or NULL to use the TMPDIR environment variable, or /tmp. */
+    const char *tmp_dir;
+    /** The function that sorts the runs in memory, or NULL to use quick sort. The external sort is stable if this
+     * sort is stable. */
+    SORT_FUNC sort;
+} ExternalSortOptions;
+
+/**
+ * Sort a file of fixed size records that can be larger than the available memory. The input is read in runs that fit
+ * in memory, each run is sorted and spilled to a temporary file, and the runs are then merged with a loser tree. If
+ * there are too many runs to merge at once, groups of runs are merged to longer runs first. The temporary files are
+ * unlinked as soon as they are created, so they are removed even if the process exits early.
+ *
+ * @param in_fd The file descriptor to read the records from, starting at its current offset.
+ * @param out_fd The file descriptor to write the sorted records to, starting at its current offset.
+ * @param size The size in bytes of each record.
+ * @param compare Pointer to a function that compares two records.
+ * @param options The options of the sort, or NULL to use the defaults.
+ * @return true if the records were sorted, false otherwise, with errno set to indicate the error. The input size must
+ * be a multiple of the record size, otherwise errno is set to EINVAL.
+ */
+bool external_sort_fd(int in_fd, int out_fd, size_t size, COMPARE_FUNC compare, const ExternalSortOptions *options);
+
+/**
+ * Sort a file of fixed size records that can be larger than the available memory. The output file is created or
+ * truncated only after the whole input has been read, so the input and the output can be the same file.
+ *
+ * @param in_path The path of the file to read the records from.
+ * @param out_path The path of the file to write the sorted records to.
+ * @param size The size in bytes of each record.
+ * @param compare Pointer to a function that compares two records.
+ * @param options The options of the sort, or NULL to use the defaults.
+ * @return true if the records were sorted, false otherwise, with errno set to indicate the error.
+ */
+bool external_sort_path(const char *in_path, const char *out_path, size_t size, COMPARE_FUNC compare,
+                        const ExternalSortOptions *options);
+
+#endif // _EXTERNAL_SORT_H
@@ -0,0 +1,140 @@
+#ifndef _I_HEAP_H
+#define _I_HEAP_H
+
+#include "common.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * An indexed binary heap data structure. Each item is associated with an integer handle, chosen by the caller, through
+ * which its key can be changed or it can be removed while it is in the heap. The handles should be small integers,
+ * since the size of the position map grows to the largest handle used.
+ */
+typedef struct {
+    /** The handles of the heap items, in heap order. */
+    size_t *heap;
+    /** The position of each handle in the heap, or SIZE_MAX if the handle is not in the heap. */
+    size_t *positions;
+    /** The item of each handle. */
+    void **items;
+    /** The number of handles that the position map can hold. */
+    size_t capacity;
+    /** The heap size. */
+    size_t size;
+    /** The comparison function. */
+    COMPARE_FUNC compare;
+} IHeap;
+
+/**
+ * Initialize the indexed binary heap data structure.
+ *
+ * @param ih Pointer to the indexed binary heap data structure.
+ * @param compare Function used to compare the items.
+ * @return true if the data structure was initialized successfully, false otherwise.
+ */
+bool ih_init(IHeap *ih, COMPARE_FUNC compare);
+
+/**
+ * Frees resources associated with the indexed binary heap data structure.
+ *
+ * @param ih Pointer to the indexed binary heap data structure to be freed.
+ */
+void ih_destroy(IHeap *ih);
+
+/**
+ * Check if the indexed binary heap contains any elements.
+ *
+ * @param ih Pointer to the indexed binary heap data structure.
+ * @return true if the heap contains elements, false otherwise.
+ */
+bool ih_is_empty(IHeap *ih);
+
+/**
+ * Return the size of the indexed binary heap.
+ *
+ * @param ih Pointer to the indexed binary heap data structure.
+ * @return The size of the indexed binary heap.
+ */
+size_t ih_size(IHeap *ih);
+
+/**
+ * Check if a handle is in the heap.
+ *
+ * @param ih Pointer to the indexed binary heap data structure.
+ * @param handle The handle.
+ * @return true if the handle is in the heap, false otherwise.
+ */
+bool ih_contains(IHeap *ih, size_t handle);
+
+/**
+ * Return the item of a handle.
+ *
+ * @param ih Pointer to the indexed binary heap data structure.
+ * @param handle The handle.
+ * @return The item of the handle, or NULL if the handle is not in the heap.
+ */
+void *ih_get(IHeap *ih, size_t handle);
+
+/**
+ * Insert an element to the heap with a handle. Note that NULL elements cannot be inserted in the heap.
+ *
+ * @param ih Pointer to the indexed binary heap data structure.
+ * @param handle The handle of the item. It must not be in the heap already.
+ * @param item Pointer to the item to be inserted to the heap.
+ * @return true if the element was added successfully, false otherwise.
+ */
+bool ih_insert(IHeap *ih, size_t handle, void *item);
+
+/**
+ * Replace the item of a handle with an item that is less than or equal to it. The new item may also be the same
+ * pointer, if the key of the item was decreased.
+ *
+ * @param ih Pointer to the indexed binary heap data structure.
+ * @param handle The handle of the item.
+ * @param item The new item.
+ * @return true if the item was replaced, false if the handle is not in the heap, or the item is NULL or bigger than the
+ * current item.
+ */
+bool ih_decrease_key(IHeap *ih, size_t handle, void *item);
+
+/**
+ * Replace the item of a handle with an item that is greater than or equal to it. The new item may also be the same
+ * pointer, if the key of the item was increased.
+ *
+ * @param ih Pointer to the indexed binary heap data structure.
+ * @param handle The handle of the item.
+ * @param item The new item.
+ * @return true if the item was replaced, false if the handle is not in the heap, or the item is NULL or smaller than
+ * the current item.
+ */
+bool ih_increase_key(IHeap *ih, size_t handle, void *item);
+
+/**
+ * Remove and return the item of a handle.
+ *
+ * @param ih Pointer to the indexed binary heap data structure.
+ * @param handle The handle of the item.
+ * @return The item of the handle, or NULL if the handle is not in the heap.
+ */
+void *ih_remove(IHeap *ih, size_t handle);
+
+/**
+ * Remove and return the minimum element from the heap.
+ *
+ * @param ih Pointer to the indexed binary heap data structure.
+ * @param handle If not NULL, set to the handle of the minimum element.
+ * @return The minimum element contained in the heap, or NULL if the heap is empty.
+ */
+void *ih_remove_min(IHeap *ih, size_t *handle);
+
+/**
+ * Return the minimum element contained in the heap, or NULL if the heap is empty.
+ *
+ * @param ih Pointer to the indexed binary heap data structure.
+ * @param handle If not NULL and the heap is not empty, set to the handle of the minimum element.
+ * @return The minimum element contained in the heap, or NULL if the heap is empty.
+ */
+void *ih_peek(IHeap *ih, size_t *handle);
+
+#endif // _I_HEAP_H
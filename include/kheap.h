@@ -0,0 +1,121 @@
+#ifndef _K_HEAP_H
+#define _K_HEAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * An item of the keyed heap: the key, and the payload that it orders.
+ */
+typedef struct {
+    /** The key of the item. */
+    uint64_t key;
+    /** The payload of the item. */
+    void *payload;
+} KHeapItem;
+
+/**
+ * A heap data structure that stores the keys of the items inline, next to their payloads, so that the comparisons are
+ * integer comparisons on the heap array, without calls of a comparison function or dereferences of the items. The heap
+ * is 4-ary, so that the four children of each node fill a cache line. Keys that are doubles are converted with
+ * kh_double_key.
+ */
+typedef struct {
+    /** The heap items. The root is stored at index 3, so that the children of each node are aligned. */
+    KHeapItem *items;
+    /** The heap capacity. */
+    size_t capacity;
+    /** The heap size. */
+    size_t size;
+} KHeap;
+
+/**
+ * Convert a double to a key, so that the order of the keys is the order of the doubles. NaN values are ordered after
+ * the infinity if their sign bit is clear, and before the negative infinity otherwise.
+ *
+ * @param value The double.
+ * @return The key.
+ */
+static inline uint64_t kh_double_key(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    // Flip all the bits of the negative numbers, and only the sign bit of the positive ones
+    return bits & (UINT64_C(1) << 63) ? ~bits : bits | (UINT64_C(1) << 63);
+}
+
+/**
+ * Convert a key that was returned by kh_double_key back to the double.
+ *
+ * @param key The key.
+ * @return The double.
+ */
+static inline double kh_key_double(uint64_t key) {
+    uint64_t bits = key & (UINT64_C(1) << 63) ? key & ~(UINT64_C(1) << 63) : ~key;
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+
+    return value;
+}
+
+/**
+ * Initialize the keyed heap data structure.
+ *
+ * @param kh Pointer to the keyed heap data structure.
+ * @return true if the data structure was initialized successfully, false otherwise.
+ */
+bool kh_init(KHeap *kh);
+
+/**
+ * Frees resources associated with the keyed heap data structure.
+ *
+ * @param kh Pointer to the keyed heap data structure to be freed.
+ */
+void kh_destroy(KHeap *kh);
+
+/**
+ * Check if the keyed heap contains any elements.
+ *
+ * @param kh Pointer to the keyed heap data structure.
+ * @return true if the heap contains elements, false otherwise.
+ */
+bool kh_is_empty(KHeap *kh);
+
+/**
+ * Return the size of the keyed heap.
+ *
+ * @param kh Pointer to the keyed heap data structure.
+ * @return The size of the keyed heap.
+ */
+size_t kh_size(KHeap *kh);
+
+/**
+ * Insert an element to the heap. Note that NULL payloads cannot be inserted in the heap.
+ *
+ * @param kh Pointer to the keyed heap data structure.
+ * @param key The key of the element.
+ * @param payload Pointer to the payload of the element.
+ * @return true if the element was added successfully, false otherwise.
+ */
+bool kh_insert(KHeap *kh, uint64_t key, void *payload);
+
+/**
+ * Remove the element with the minimum key from the heap, and return its payload.
+ *
+ * @param kh Pointer to the keyed heap data structure.
+ * @param key If not NULL and the heap is not empty, set to the minimum key.
+ * @return The payload of the element with the minimum key, or NULL if the heap is empty.
+ */
+void *kh_remove_min(KHeap *kh, uint64_t *key);
+
+/**
+ * Return the payload of the element with the minimum key, or NULL if the heap is empty.
+ *
+ * @param kh Pointer to the keyed heap data structure.
+ * @param key If not NULL and the heap is not empty, set to the minimum key.
+ * @return The payload of the element with the minimum key, or NULL if the heap is empty.
+ */
+void *kh_peek(KHeap *kh, uint64_t *key);
+
+#endif // _K_HEAP_H
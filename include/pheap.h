@@ -0,0 +1,117 @@
+#ifndef _P_HEAP_H
+#define _P_HEAP_H
+
+#include "common.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * The pairing heap node.
+ */
+typedef struct PHeapNode {
+    /** The item. */
+    void *item;
+    /** The leftmost child of the node. */
+    struct PHeapNode *child;
+    /** The next sibling of the node. */
+    struct PHeapNode *next;
+    /** The previous sibling of the node, or its parent if it is the leftmost child. */
+    struct PHeapNode *prev;
+} PHeapNode;
+
+/**
+ * A pairing heap data structure. It is a heap ordered tree, in which the children of a node are kept in a list. Insert,
+ * meld and decrease key link two trees, which takes constant time, and the removal of the minimum merges the children
+ * of the root in pairs.
+ */
+typedef struct {
+    /** The root of the heap. */
+    PHeapNode *root;
+    /** The heap size. */
+    size_t size;
+    /** The nodes of the removed items, which are reused by the inserts. */
+    PHeapNode *free_nodes;
+    /** The comparison function. */
+    COMPARE_FUNC compare;
+} PHeap;
+
+/**
+ * Initialize the pairing heap data structure.
+ *
+ * @param ph Pointer to the pairing heap data structure.
+ * @param compare_func Function used to compare the items.
+ * @return true if the data structure was initialized successfully, false otherwise.
+ */
+bool ph_init(PHeap *ph, COMPARE_FUNC compare_func);
+
+/**
+ * Frees resources associated with the pairing heap data structure.
+ *
+ * @param ph Pointer to the pairing heap data structure to be freed.
+ */
+void ph_destroy(PHeap *ph);
+
+/**
+ * Check if the pairing heap contains any elements.
+ *
+ * @param ph Pointer to the pairing heap data structure.
+ * @return true if the heap contains elements, false otherwise.
+ */
+bool ph_is_empty(PHeap *ph);
+
+/**
+ * Return the size of the pairing heap.
+ *
+ * @param ph Pointer to the pairing heap data structure.
+ * @return The size of the pairing heap.
+ */
+size_t ph_size(PHeap *ph);
+
+/**
+ * Insert an element to the heap. Note that NULL elements cannot be inserted in the heap.
+ *
+ * @param ph Pointer to the pairing heap data structure.
+ * @param item Pointer to the item to be inserted to the heap.
+ * @param node If not NULL, set to the node of the item, which can be passed to ph_decrease_key until the item is
+ * removed.
+ * @return true if the element was added successfully, false otherwise.
+ */
+bool ph_insert(PHeap *ph, void *item, PHeapNode **node);
+
+/**
+ * Replace the item of a node with a smaller or equal item.
+ *
+ * @param ph Pointer to the pairing heap data structure.
+ * @param node The node of the item, as returned by ph_insert.
+ * @param item The new item.
+ * @return true if the item was replaced, false if it is NULL or bigger than the current item.
+ */
+bool ph_decrease_key(PHeap *ph, PHeapNode *node, void *item);
+
+/**
+ * Move all the elements of another heap with the same comparison function to the heap. The other heap is left empty,
+ * and it must still be destroyed.
+ *
+ * @param ph Pointer to the pairing heap data structure.
+ * @param other Pointer to the pairing heap data structure whose elements are moved.
+ */
+void ph_meld(PHeap *ph, PHeap *other);
+
+/**
+ * Remove and return the minimum element from the heap.
+ *
+ * @param ph Pointer to the pairing heap data structure.
+ * @return The minimum element contained in the heap, or NULL if the heap is empty.
+ */
+void *ph_remove_min(PHeap *ph);
+
+/**
+ * Return the minimum element contained in the heap, or NULL if the heap is empty.
+ *
+ * @param ph Pointer to the pairing heap data structure.
+ * @return The minimum element contained in the heap, or NULL if the heap is empty.
+ */
+void *ph_peek(PHeap *ph);
+
+#endif // _P_HEAP_H
@@ -0,0 +1,111 @@
+#ifndef _R_HEAP_H
+#define _R_HEAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// The number of buckets of the radix heap: one for the keys that are equal to the last removed key, and one for each
+// bit position in which a key can first differ from it
+#define RH_NUM_BUCKETS 65
+
+/**
+ * An item of the radix heap: the key, and the payload that it orders.
+ */
+typedef struct {
+    /** The key of the item. */
+    uint64_t key;
+    /** The payload of the item. */
+    void *payload;
+} RHeapItem;
+
+/**
+ * A bucket of the radix heap.
+ */
+typedef struct {
+    /** The bucket items. */
+    RHeapItem *items;
+    /** The bucket capacity. */
+    size_t capacity;
+    /** The bucket size. */
+    size_t size;
+} RHeapBucket;
+
+/**
+ * A monotone radix heap data structure, for unsigned 64-bit keys where the removed keys never decrease, as in timers or
+ * in Dijkstra's algorithm with integer weights. An item is kept in the bucket of the highest bit in which its key
+ * differs from the last removed key. When the bucket of the equal keys is empty, the first non empty bucket is
+ * distributed to the lower buckets, so each item moves down at most 64 times and no keys are compared to each other.
+ */
+typedef struct {
+    /** The buckets. */
+    RHeapBucket buckets[RH_NUM_BUCKETS];
+    /** The last removed key, which no inserted key can be smaller than. */
+    uint64_t last;
+    /** The heap size. */
+    size_t size;
+} RHeap;
+
+/**
+ * Initialize the radix heap data structure.
+ *
+ * @param rh Pointer to the radix heap data structure.
+ * @return true if the data structure was initialized successfully, false otherwise.
+ */
+bool rh_init(RHeap *rh);
+
+/**
+ * Frees resources associated with the radix heap data structure.
+ *
+ * @param rh Pointer to the radix heap data structure to be freed.
+ */
+void rh_destroy(RHeap *rh);
+
+/**
+ * Check if the radix heap contains any elements.
+ *
+ * @param rh Pointer to the radix heap data structure.
+ * @return true if the heap contains elements, false otherwise.
+ */
+bool rh_is_empty(RHeap *rh);
+
+/**
+ * Return the size of the radix heap.
+ *
+ * @param rh Pointer to the radix heap data structure.
+ * @return The size of the radix heap.
+ */
+size_t rh_size(RHeap *rh);
+
+/**
+ * Insert an element to the heap. Note that NULL payloads cannot be inserted in the heap, and that the key cannot be
+ * smaller than the last removed key.
+ *
+ * @param rh Pointer to the radix heap data structure.
+ * @param key The key of the element.
+ * @param payload Pointer to the payload of the element.
+ * @return true if the element was added successfully, false otherwise.
+ */
+bool rh_insert(RHeap *rh, uint64_t key, void *payload);
+
+/**
+ * Remove the element with the minimum key from the heap, and return its payload.
+ *
+ * @param rh Pointer to the radix heap data structure.
+ * @param key If not NULL and an element is returned, set to the minimum key.
+ * @return The payload of the element with the minimum key, or NULL if the heap is empty or the memory to distribute a
+ * bucket could not be allocated, in which case the heap is not modified.
+ */
+void *rh_remove_min(RHeap *rh, uint64_t *key);
+
+/**
+ * Return the payload of the element with the minimum key.
+ *
+ * @param rh Pointer to the radix heap data structure.
+ * @param key If not NULL and an element is returned, set to the minimum key.
+ * @return The payload of the element with the minimum key, or NULL if the heap is empty or the memory to distribute a
+ * bucket could not be allocated, in which case the heap is not modified.
+ */
+void *rh_peek(RHeap *rh, uint64_t *key);
+
+#endif // _R_HEAP_H
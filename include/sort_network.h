@@ -0,0 +1,90 @@
+#ifndef _SORT_NETWORK_H
+#define _SORT_NETWORK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The maximum number of elements that the sorting networks sort
+#define SORT_NETWORK_MAX 16
+
+/**
+ * Sort a small array of signed 32-bit integers with a bitonic sorting network. The network runs on AVX2 or SSE4.2
+ * when the processor supports them, and on scalar code otherwise. The environment variable SORT_NETWORK_ISA can select
+ * the "sse4.2" or the "scalar" code instead, for all the networks, so that it can be tested on any processor.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base, at most SORT_NETWORK_MAX.
+ */
+void sort_network_i32(int32_t *base, size_t n);
+
+/**
+ * Sort a small array of unsigned 32-bit integers with a bitonic sorting network.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base, at most SORT_NETWORK_MAX.
+ */
+void sort_network_u32(uint32_t *base, size_t n);
+
+/**
+ * Sort a small array of signed 64-bit integers with a bitonic sorting network.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base, at most SORT_NETWORK_MAX.
+ */
+void sort_network_i64(int64_t *base, size_t n);
+
+/**
+ * Sort a small array of unsigned 64-bit integers with a bitonic sorting network.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base, at most SORT_NETWORK_MAX.
+ */
+void sort_network_u64(uint64_t *base, size_t n);
+
+/**
+ * Merge two sorted arrays of signed 32-bit integers with a bitonic merge network, which runs on AVX2 when the
+ * processor supports it. Otherwise the arrays are merged by scalar code without branches on the keys.
+ *
+ * @param dest The destination array. It must not overlap the left array, but the right array may be the end of it,
+ * right after the first n1 elements, so that a run can be merged in place with a copy of the left run.
+ * @param left The left array.
+ * @param n1 The number of elements in the left array.
+ * @param right The right array.
+ * @param n2 The number of elements in the right array.
+ */
+void sort_network_merge_i32(int32_t *dest, const int32_t *left, size_t n1, const int32_t *right, size_t n2);
+
+/**
+ * Merge two sorted arrays of unsigned 32-bit integers with a bitonic merge network.
+ *
+ * @param dest The destination array. It must not overlap the left array, but the right array may be the end of it.
+ * @param left The left array.
+ * @param n1 The number of elements in the left array.
+ * @param right The right array.
+ * @param n2 The number of elements in the right array.
+ */
+void sort_network_merge_u32(uint32_t *dest, const uint32_t *left, size_t n1, const uint32_t *right, size_t n2);
+
+/**
+ * Merge two sorted arrays of signed 64-bit integers with a bitonic merge network.
+ *
+ * @param dest The destination array. It must not overlap the left array, but the right array may be the end of it.
+ * @param left The left array.
+ * @param n1 The number of elements in the left array.
+ * @param right The right array.
+ * @param n2 The number of elements in the right array.
+ */
+void sort_network_merge_i64(int64_t *dest, const int64_t *left, size_t n1, const int64_t *right, size_t n2);
+
+/**
+ * Merge two sorted arrays of unsigned 64-bit integers with a bitonic merge network.
+ *
+ * @param dest The destination array. It must not overlap the left array, but the right array may be the end of it.
+ * @param left The left array.
+ * @param n1 The number of elements in the left array.
+ * @param right The right array.
+ * @param n2 The number of elements in the right array.
+ */
+void sort_network_merge_u64(uint64_t *dest, const uint64_t *left, size_t n1, const uint64_t *right, size_t n2);
+
+#endif // _SORT_NETWORK_H
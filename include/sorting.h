@@ -5,6 +5,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 /**
  * Prototype for a function that sorts an array.
@@ -16,6 +17,48 @@
  */
 typedef void (*SORT_FUNC) (void *base, size_t n, size_t size, COMPARE_FUNC compare);
 
+/**
+ * Prototype for a function that returns the radix sort key of an element. Elements are sorted in increasing order of
+ * their keys.
+ *
+ * @param item Pointer to the element.
+ * @return The key of the element.
+ */
+typedef uint64_t (*KEY_FUNC) (const void *item);
+
+/**
+ * The statistics of the sort calls of a thread. They are only counted if the library is built with the SORT_STATS
+ * option, otherwise they stay zero. The comparisons and moves of the typed sorts, the sorting networks and the radix
+ * sorts of primitive types are not counted.
+ */
+typedef struct {
+    /** The number of calls to the comparison function. */
+    uint64_t comparisons;
+    /** The number of elements copied, not counting the swaps. */
+    uint64_t moves;
+    /** The number of element swaps. */
+    uint64_t swaps;
+    /** The number of bytes allocated for auxiliary arrays. */
+    uint64_t aux_bytes;
+    /** The deepest nesting of partitioning or merging levels. The levels are counted per thread. */
+    uint64_t max_depth;
+} SortStats;
+
+/**
+ * Start counting the statistics of the sort calls of the calling thread. The statistics are reset, and they are
+ * updated by sort_stats_end. The threads of the parallel sorts that are called from the calling thread are counted as
+ * well.
+ *
+ * @param stats The statistics.
+ */
+void sort_stats_begin(SortStats *stats);
+
+/**
+ * Stop counting the statistics of the sort calls of the calling thread, and update the statistics that were passed to
+ * sort_stats_begin.
+ */
+void sort_stats_end(void);
+
 /**
  * Sort an array using insertion sort.
  *
@@ -57,7 +100,8 @@ void selection_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare);
 void shell_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare);
 
 /**
- * Sort an array using merge sort.
+ * Sort an array using merge sort. If the auxiliary array cannot be allocated, the array is sorted with
+ * in_place_merge_sort.
  *
  * @param base A pointer to the first element of the array to be sorted.
  * @param n The number of elements in the array pointed by base.
@@ -67,7 +111,69 @@ void shell_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare);
 void merge_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare);
 
 /**
- * Sort an array using quick sort.
+ * Sort an array using merge sort, with an auxiliary array that is provided by the caller, so that it can be reused
+ * across many sorts without allocating memory.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ * @param scratch The auxiliary array, of at least n elements of the given size.
+ */
+void merge_sort_scratch(void *base, size_t n, size_t size, COMPARE_FUNC compare, void *scratch);
+
+/**
+ * Sort an array using a stable merge sort that does not allocate memory. The runs are merged in place: runs that fit in
+ * a buffer of 4096 bytes on the stack are merged through it, and longer runs are split by binary search and rotation,
+ * so the running time is O(n log^2 n) in the worst case, and O(n) for sorted arrays. The recursion depth is O(log n),
+ * since the merges recurse on the smaller pair of runs.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ */
+void in_place_merge_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare);
+
+/**
+ * Sort an array using merge sort with multiple threads. The result is identical to the result of merge_sort.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ * @param nthreads The number of threads to use, or zero to use one thread per online processor.
+ * @return true if the array was sorted, false if the auxiliary array could not be allocated.
+ */
+bool parallel_merge_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare, size_t nthreads);
+
+/**
+ * Sort an array using heap sort. The running time is O(n log n) in the worst case, and no memory is allocated. The
+ * heap is sifted down bottom-up, which takes about half the comparisons of the usual sift down.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ */
+void heap_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare);
+
+/**
+ * Sort an array using smooth sort, a variant of heap sort that keeps the array prefix as a sequence of Leonardo heaps.
+ * The running time is O(n log n) in the worst case, and no memory is allocated, like heap sort, but it is adaptive: it
+ * approaches O(n) as the array gets closer to sorted.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ */
+void smooth_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare);
+
+/**
+ * Sort an array using quick sort. The partitioning element is selected with the median of three (or Tukey's ninther
+ * for large arrays), and the sort falls back to heap sort when the recursion gets too deep, so the running time is
+ * O(n log n) in the worst case.
  *
  * @param base A pointer to the first element of the array to be sorted.
  * @param n The number of elements in the array pointed by base.
@@ -76,4 +182,234 @@ void merge_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare);
  */
 void quick_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare);
 
+/**
+ * Sort an array using quick sort with three way partitioning. The array is partitioned with the Bentley-McIlroy
+ * partitioning to the elements less than, equal to and greater than the partitioning element, and only the less and
+ * greater parts are sorted recursively, so arrays with few distinct elements are sorted in linear time. It falls back
+ * to heap sort when the recursion gets too deep, so the running time is O(n log n) in the worst case.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ */
+void quick_sort_3way(void *base, size_t n, size_t size, COMPARE_FUNC compare);
+
+/**
+ * Sort an array using quick sort with multiple threads. The partitions are distributed to the threads with work
+ * stealing, and partitions smaller than a cutoff are sorted with the sequential quick sort.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ * @param nthreads The number of threads to use, or zero to use one thread per online processor.
+ */
+void parallel_quick_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare, size_t nthreads);
+
+/**
+ * Rearrange an array so that the element at position k is the one that would be in that position if the array was
+ * sorted, no element before it is greater, and no element after it is less. The implementation is an introselect,
+ * which partitions the array as quick sort, and falls back to the median of medians when the partitions are bad, so
+ * the running time is linear in the worst case.
+ *
+ * @param base A pointer to the first element of the array.
+ * @param n The number of elements in the array pointed by base.
+ * @param k The index of the element to select. Nothing is done if it is not less than n.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ */
+void quick_select(void *base, size_t n, size_t k, size_t size, COMPARE_FUNC compare);
+
+/**
+ * Sort the k smallest elements of an array to its start, in O(n + k log k) time. The order of the rest of the elements
+ * is unspecified.
+ *
+ * @param base A pointer to the first element of the array.
+ * @param n The number of elements in the array pointed by base.
+ * @param k The number of elements to sort. All the elements are sorted if it is greater than n.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ */
+void partial_sort(void *base, size_t n, size_t k, size_t size, COMPARE_FUNC compare);
+
+/**
+ * Copy the k smallest elements of an array to a destination array, in sorted order. The array is read once and is not
+ * modified, and the destination array is used as a max heap of the smallest elements seen, so no other memory is
+ * needed. The running time is O(n log k).
+ *
+ * @param dest A pointer to the first element of the destination array, which must have room for k elements.
+ * @param base A pointer to the first element of the array.
+ * @param n The number of elements in the array pointed by base.
+ * @param k The number of elements to copy.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ * @return The number of elements copied, which is the minimum of k and n.
+ */
+size_t top_k(void *dest, const void *base, size_t n, size_t k, size_t size, COMPARE_FUNC compare);
+
+/**
+ * Sort an array using pattern-defeating quick sort. It runs in linear time for sorted, reverse sorted and partially
+ * sorted arrays, handles arrays with many equal elements efficiently, and falls back to heap sort on inputs that cause
+ * bad partitions, so the running time is O(n log n) in the worst case.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ */
+void pdq_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare);
+
+/**
+ * Sort an array using tim sort. The sort is stable and adaptive: it finds the runs that are already sorted, extends
+ * the short runs with binary insertion sort, and merges the runs with galloping, so that nearly sorted arrays are
+ * sorted with close to linear comparisons. The temporary array holds at most half of the array.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ * @return true if the array was sorted, false if the temporary array could not be allocated.
+ */
+bool tim_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare);
+
+/**
+ * Sort an array of unsigned 32-bit integers using LSD radix sort. The sort is stable and makes one pass over
+ * the array for each 11-bit digit of the keys, skipping the digits that are the same for all the keys.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @return true if the array was sorted, false if the auxiliary array could not be allocated.
+ */
+bool radix_sort_u32(uint32_t *base, size_t n);
+
+/**
+ * Sort an array of signed 32-bit integers using LSD radix sort. The sort is stable and makes one pass over
+ * the array for each 11-bit digit of the keys, skipping the digits that are the same for all the keys.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @return true if the array was sorted, false if the auxiliary array could not be allocated.
+ */
+bool radix_sort_i32(int32_t *base, size_t n);
+
+/**
+ * Sort an array of unsigned 64-bit integers using LSD radix sort. The sort is stable and makes one pass over
+ * the array for each 11-bit digit of the keys, skipping the digits that are the same for all the keys.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @return true if the array was sorted, false if the auxiliary array could not be allocated.
+ */
+bool radix_sort_u64(uint64_t *base, size_t n);
+
+/**
+ * Sort an array of signed 64-bit integers using LSD radix sort. The sort is stable and makes one pass over
+ * the array for each 11-bit digit of the keys, skipping the digits that are the same for all the keys.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @return true if the array was sorted, false if the auxiliary array could not be allocated.
+ */
+bool radix_sort_i64(int64_t *base, size_t n);
+
+/**
+ * Sort an array of floats using LSD radix sort. The sort is stable and makes one pass over
+ * the array for each 11-bit digit of the keys, skipping the digits that are the same for all the keys.
+ * Negative zero is placed before zero, and NaN values are placed at the start or the end of the array, depending on
+ * their sign bit.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @return true if the array was sorted, false if the auxiliary array could not be allocated.
+ */
+bool radix_sort_f32(float *base, size_t n);
+
+/**
+ * Sort an array of doubles using LSD radix sort. The sort is stable and makes one pass over
+ * the array for each 11-bit digit of the keys, skipping the digits that are the same for all the keys.
+ * Negative zero is placed before zero, and NaN values are placed at the start or the end of the array, depending on
+ * their sign bit.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @return true if the array was sorted, false if the auxiliary array could not be allocated.
+ */
+bool radix_sort_f64(double *base, size_t n);
+
+/**
+ * Sort an array using LSD radix sort on a 64-bit unsigned key of each element. The sort is stable and makes one pass
+ * over the array for each 11-bit digit of the keys, skipping the digits that are the same for all the keys.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param key Pointer to a function that returns the key of an element.
+ * @return true if the array was sorted, false if the auxiliary array could not be allocated.
+ */
+bool radix_sort_key(void *base, size_t n, size_t size, KEY_FUNC key);
+
+/**
+ * Sort an array of unsigned 64-bit integers in place using American flag sort, which is an MSD radix sort with 8-bit
+ * digits. The elements are moved to their buckets by following permutation cycles, so no auxiliary array is needed.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ */
+void american_flag_sort_u64(uint64_t *base, size_t n);
+
+/**
+ * Sort an array of unsigned 64-bit integers in place using American flag sort with multiple threads. The digits are
+ * counted in parallel, and each thread permutes its own stripe of every bucket. The elements that could not be placed
+ * are repaired in further rounds. The buckets are then sorted in parallel.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param nthreads The number of threads to use, or zero to use one thread per online processor.
+ */
+void parallel_american_flag_sort_u64(uint64_t *base, size_t n, size_t nthreads);
+
+/**
+ * Sort an array indirectly: find the permutation of the array element indexes that sorts the array, without moving
+ * the elements. The permutation is found with a stable merge sort, so the indexes of equal elements are in increasing
+ * order. Together with apply_permutation, it sorts arrays of large elements by moving each element once.
+ *
+ * @param perm The array where the permutation is stored, with room for n indexes. The element at position i of the
+ * sorted array is the element at position perm[i] of the array.
+ * @param base A pointer to the first element of the array.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ * @return true if the permutation was found, false if the auxiliary array could not be allocated.
+ */
+bool arg_sort(size_t *perm, const void *base, size_t n, size_t size, COMPARE_FUNC compare);
+
+/**
+ * Sort an array indirectly, comparing the key prefixes of the elements first. The pairs of the key prefix and the
+ * index of each element are sorted with radix sort, and the comparison function is only called for elements with
+ * equal prefixes. The prefix must be consistent with the comparison function: if an element is less than another, its
+ * prefix must be less than or equal to the prefix of the other. The indexes of equal elements are in increasing order.
+ *
+ * @param perm The array where the permutation is stored, with room for n indexes.
+ * @param base A pointer to the first element of the array.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ * @param prefix Pointer to a function that returns the key prefix of an element.
+ * @return true if the permutation was found, false if the auxiliary arrays could not be allocated.
+ */
+bool arg_sort_prefix(size_t *perm, const void *base, size_t n, size_t size, COMPARE_FUNC compare, KEY_FUNC prefix);
+
+/**
+ * Reorder an array in place by a permutation, so that the element at position i is the element that was at position
+ * perm[i]. The cycles of the permutation are followed, so each element is moved once.
+ *
+ * @param base A pointer to the first element of the array.
+ * @param perm The permutation, as an array of the indexes of the array elements. It is modified during the reordering,
+ * and restored when it returns.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ */
+void apply_permutation(void *base, size_t *perm, size_t n, size_t size);
+
 #endif // _SORTING_H
@@ -0,0 +1,220 @@
+#ifndef _TYPED_SORT_H
+#define _TYPED_SORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The array size below which the typed quick sort and merge sort use their base case sort
+#define TYPED_SORT_CUTOFF 16
+
+/**
+ * Return the recursion depth after which the typed quick sort switches to heap sort, which is 2 * floor(log2(n)).
+ *
+ * @param n The number of elements in the array.
+ * @return The recursion depth limit.
+ */
+static inline size_t typed_sort_depth_limit(size_t n) {
+    size_t depth = 0;
+    while (n > 1) {
+        depth += 2;
+        n >>= 1;
+    }
+
+    return depth;
+}
+
+/**
+ * Declare the typed sorts for an element type. The sorts are named after the prefix, for example the quick sort of
+ * the prefix int is int_quick_sort.
+ *
+ * @param name The prefix of the names of the sorts.
+ * @param type The type of the elements.
+ */
+#define DECLARE_SORT(name, type) \
+    void name##_insertion_sort(type *base, size_t n); \
+    bool name##_merge_sort(type *base, size_t n); \
+    void name##_quick_sort(type *base, size_t n); \
+    void name##_heap_sort(type *base, size_t n);
+
+/**
+ * Define the typed sorts for an element type, with the comparison inlined. Defines insertion sort, merge sort, which is
+ * stable and returns false if its auxiliary array cannot be allocated, quick sort, implemented as an introsort, and
+ * heap sort.
+ *
+ * @param name The prefix of the names of the sorts.
+ * @param type The type of the elements.
+ * @param less An expression that is true if the element a is placed before the element b.
+ */
+#define DEFINE_SORT(name, type, less) \
+    DEFINE_SORT_WITH_KERNELS(name, type, less, name##_insertion_sort, name##_merge_runs)
+
+/**
+ * Define the typed sorts for an element type, with the comparison inlined, and with the kernels that quick sort and
+ * merge sort use. The base case sort sorts the arrays shorter than TYPED_SORT_CUTOFF, and the merge kernel merges two
+ * sorted runs. The kernels must be stable for merge sort to be stable, which holds for any kernel if keys are equal
+ * only when they are identical.
+ *
+ * @param name The prefix of the names of the sorts.
+ * @param type The type of the elements.
+ * @param less An expression that is true if the element a is placed before the element b.
+ * @param base_sort A function that sorts an array of the type, given the array and its size.
+ * @param merge_runs A function that merges two sorted runs to a destination, given the destination, the left run and
+ * its size, and the right run and its size. The right run is the end of the destination.
+ */
+#define DEFINE_SORT_WITH_KERNELS(name, type, less, base_sort, merge_runs) \
+    static inline bool name##_less(type a, type b) { \
+        return (less); \
+    } \
+    \
+    static inline void name##_swap(type *a, type *b) { \
+        type temp = *a; \
+        *a = *b; \
+        *b = temp; \
+    } \
+    \
+    void name##_insertion_sort(type *base, size_t n) { \
+        for (size_t i = 1; i < n; i++) { \
+            type element = base[i]; \
+            size_t j = i; \
+            for (; j > 0 && name##_less(element, base[j - 1]); j--) { \
+                base[j] = base[j - 1]; \
+            } \
+            base[j] = element; \
+        } \
+    } \
+    \
+    static inline void name##_merge_runs(type *dest, const type *left, size_t n1, const type *right, size_t n2) { \
+        /* Select the next element without branching on the comparison, which is hard to predict */ \
+        size_t i = 0; \
+        size_t j = 0; \
+        size_t k = 0; \
+        while (i < n1 && j < n2) { \
+            bool take_right = name##_less(right[j], left[i]); \
+            dest[k++] = take_right ? right[j] : left[i]; \
+            j += take_right; \
+            i += !take_right; \
+        } \
+        while (i < n1) { \
+            dest[k++] = left[i++]; \
+        } \
+    } \
+    \
+    static void name##_merge_sort_impl(type *base, type *aux, size_t n) { \
+        if (n < TYPED_SORT_CUTOFF) { \
+            base_sort(base, n); \
+            return; \
+        } \
+        size_t mid = n / 2; \
+        name##_merge_sort_impl(base, aux, mid); \
+        name##_merge_sort_impl(base + mid, aux, n - mid); \
+        if (!name##_less(base[mid], base[mid - 1])) { \
+            return; \
+        } \
+        /* Only the left half is copied, the right half is merged in place */ \
+        memcpy(aux, base, mid * sizeof(type)); \
+        merge_runs(base, aux, mid, base + mid, n - mid); \
+    } \
+    \
+    bool name##_merge_sort(type *base, size_t n) { \
+        if (n < 2) { \
+            return true; \
+        } \
+        type *aux = malloc(n / 2 * sizeof(type)); \
+        if (!aux) { \
+            return false; \
+        } \
+        name##_merge_sort_impl(base, aux, n); \
+        free(aux); \
+        return true; \
+    } \
+    \
+    static void name##_sift_down(type *base, size_t pos, size_t n) { \
+        type element = base[pos]; \
+        for (;;) { \
+            size_t child = 2 * pos + 1; \
+            if (child >= n) { \
+                break; \
+            } \
+            if (child + 1 < n && name##_less(base[child], base[child + 1])) { \
+                child++; \
+            } \
+            if (!name##_less(element, base[child])) { \
+                break; \
+            } \
+            base[pos] = base[child]; \
+            pos = child; \
+        } \
+        base[pos] = element; \
+    } \
+    \
+    void name##_heap_sort(type *base, size_t n) { \
+        for (size_t i = n / 2; i > 0; i--) { \
+            name##_sift_down(base, i - 1, n); \
+        } \
+        for (size_t i = n; i > 1; i--) { \
+            name##_swap(&base[0], &base[i - 1]); \
+            name##_sift_down(base, 0, i - 1); \
+        } \
+    } \
+    \
+    static void name##_quick_sort_impl(type *base, size_t n, size_t depth) { \
+        while (n >= TYPED_SORT_CUTOFF) { \
+            if (depth == 0) { \
+                name##_heap_sort(base, n); \
+                return; \
+            } \
+            depth--; \
+            /* Sort the first, middle and last elements, and use their median as the pivot. The first and the */ \
+            /* last elements then stop the partitioning scans. */ \
+            size_t mid = n / 2; \
+            if (name##_less(base[mid], base[0])) { \
+                name##_swap(&base[0], &base[mid]); \
+            } \
+            if (name##_less(base[n - 1], base[mid])) { \
+                name##_swap(&base[mid], &base[n - 1]); \
+                if (name##_less(base[mid], base[0])) { \
+                    name##_swap(&base[0], &base[mid]); \
+                } \
+            } \
+            name##_swap(&base[0], &base[mid]); \
+            type pivot = base[0]; \
+            size_t i = 0; \
+            size_t j = n; \
+            for (;;) { \
+                while (name##_less(base[++i], pivot)) { \
+                } \
+                while (name##_less(pivot, base[--j])) { \
+                } \
+                if (i >= j) { \
+                    break; \
+                } \
+                name##_swap(&base[i], &base[j]); \
+            } \
+            name##_swap(&base[0], &base[j]); \
+            /* Recurse into the smaller part, and loop on the larger one */ \
+            if (j < n - j - 1) { \
+                name##_quick_sort_impl(base, j, depth); \
+                base += j + 1; \
+                n -= j + 1; \
+            } else { \
+                name##_quick_sort_impl(base + j + 1, n - j - 1, depth); \
+                n = j; \
+            } \
+        } \
+        base_sort(base, n); \
+    } \
+    \
+    void name##_quick_sort(type *base, size_t n) { \
+        name##_quick_sort_impl(base, n, typed_sort_depth_limit(n)); \
+    }
+
+DECLARE_SORT(int, int)
+DECLARE_SORT(long, long)
+DECLARE_SORT(double, double)
+DECLARE_SORT(uint64, uint64_t)
+DECLARE_SORT(string, const char *)
+
+#endif // _TYPED_SORT_H
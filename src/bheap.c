@@ -1,6 +1,5 @@
 #include "bheap.h"
 
-#include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -100,6 +99,38 @@ bool bh_init(BHeap *bh, COMPARE_FUNC compare) {
     return true;
 }
 
+static void bh_heapify(BHeap *bh) {
+    // Sink down all the items that have children, starting from the last one
+    for (size_t pos = bh->size / 2; pos > 0; pos--) {
+        bh_sink_down(bh, pos - 1);
+    }
+}
+
+bool bh_init_from_array(BHeap *bh, COMPARE_FUNC compare, void **items, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (!items[i]) {
+            // NULL items cannot be added to the heap
+            return false;
+        }
+    }
+    bh->capacity = n > 0 ? n : 1;
+    bh->items = malloc(bh->capacity * sizeof(void *));
+    if (!bh->items) {
+        return false;
+    }
+    if (n > 0) {
+        memcpy(bh->items, items, n * sizeof(void *));
+    }
+    bh->size = n;
+    bh->compare = compare;
+    bh_heapify(bh);
+
+    // Check the heap invariant
+    CHECK_SAMPLED(bh_is_heap(bh, 0));
+
+    return true;
+}
+
 void bh_destroy(BHeap *bh) {
     free(bh->items);
 }
@@ -112,6 +143,10 @@ size_t bh_size(BHeap *bh) {
     return bh->size;
 }
 
+bool bh_reserve(BHeap *bh, size_t capacity) {
+    return capacity <= bh->capacity || bh_resize(bh, capacity);
+}
+
 bool bh_insert(BHeap *bh, void *item) {
     if (!item) {
         // NULL items cannot be added to the heap
@@ -128,7 +163,46 @@ bool bh_insert(BHeap *bh, void *item) {
     bh->size++;
 
     // Check the heap invariant
-    assert(bh_is_heap(bh, 0));
+    CHECK(bh->compare(bh->items[0], item) <= 0);
+    CHECK_SAMPLED(bh_is_heap(bh, 0));
+
+    return true;
+}
+
+bool bh_insert_batch(BHeap *bh, void **items, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (!items[i]) {
+            // NULL items cannot be added to the heap
+            return false;
+        }
+    }
+    if (bh->size + n > bh->capacity) {
+        // Grow the array at least by doubling, so that repeated batches take amortized linear time
+        size_t new_capacity = 2 * bh->capacity > bh->size + n ? 2 * bh->capacity : bh->size + n;
+        if (!bh_resize(bh, new_capacity)) {
+            // Could not resize the underlying array
+            return false;
+        }
+    }
+
+    // Append the items
+    if (n > 0) {
+        memcpy(bh->items + bh->size, items, n * sizeof(void *));
+    }
+    if (n >= bh->size) {
+        // The batch is at least as big as the heap, so rebuilding it takes time linear to the batch
+        bh->size += n;
+        bh_heapify(bh);
+    } else {
+        // Move each item to the correct position
+        for (size_t i = 0; i < n; i++) {
+            bh_swim_up(bh, bh->size);
+            bh->size++;
+        }
+    }
+
+    // Check the heap invariant
+    CHECK_SAMPLED(bh_is_heap(bh, 0));
 
     return true;
 }
@@ -151,7 +225,9 @@ void *bh_remove_min(BHeap *bh) {
     }
 
     // Check the heap invariant
-    assert(bh_is_heap(bh, 0));
+    CHECK(bh->size < 2 || bh->compare(bh->items[0], bh->items[LEFT_CHILD(0)]) <= 0);
+    CHECK(bh->size < 3 || bh->compare(bh->items[0], bh->items[RIGHT_CHILD(0)]) <= 0);
+    CHECK_SAMPLED(bh_is_heap(bh, 0));
 
     return item;
 }
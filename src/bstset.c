@@ -1,4 +1,3 @@
-#include <assert.h>
 #include <stdlib.h>
 
 #include "bstset.h"
@@ -222,7 +221,8 @@ bool bsts_add(BSTSet *bs, void *item) {
     (*node)->right = NULL;
 
     // Check the invariants
-    assert(bsts_is_bst(bs->root, bs->compare, NULL, NULL));
+    CHECK(bs->root != NULL);
+    CHECK_SAMPLED(bsts_is_bst(bs->root, bs->compare, NULL, NULL));
 
     return true;
 }
@@ -239,11 +239,12 @@ void *bsts_remove_min(BSTSet *bs) {
     }
 
     // Free resources
+    CHECK(node->left == NULL);
     void *item = node->item;
     free(node);
 
     // Check the invariants
-    assert(bsts_is_bst(bs->root, bs->compare, NULL, NULL));
+    CHECK_SAMPLED(bsts_is_bst(bs->root, bs->compare, NULL, NULL));
 
     return item;
 }
@@ -260,11 +261,12 @@ void *bsts_remove_max(BSTSet *bs) {
     }
 
     // Free resources
+    CHECK(node->right == NULL);
     void *item = node->item;
     free(node);
 
     // Check the invariants
-    assert(bsts_is_bst(bs->root, bs->compare, NULL, NULL));
+    CHECK_SAMPLED(bsts_is_bst(bs->root, bs->compare, NULL, NULL));
 
     return item;
 }
@@ -325,7 +327,8 @@ void *bsts_remove(BSTSet *bs, void *item) {
     free(current);
 
     // Check the invariants
-    assert(bsts_is_bst(bs->root, bs->compare, NULL, NULL));
+    CHECK(bs->compare(item, removed_item) == 0);
+    CHECK_SAMPLED(bsts_is_bst(bs->root, bs->compare, NULL, NULL));
 
     return removed_item;
 }
@@ -0,0 +1,175 @@
+#include "dheap.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// The size of a cache line in bytes, to which the children of each node are aligned
+#define CACHE_LINE_SIZE 64
+
+// The root is stored at index d - 1, so the children of the node at index i start at index d * (i - d + 2), which is
+// aligned to the arity, and the parent of the node at index i is at index i / d + d - 2. The arity is a power of two,
+// so the multiplication and the division are shifts.
+#define FIRST_CHILD(dh, x) (((x) - (dh)->arity + 2) << (dh)->shift)
+#define PARENT(dh, x) (((x) >> (dh)->shift) + (dh)->arity - 2)
+#define ROOT(dh) ((dh)->arity - 1)
+
+/**
+ * Resize the underlying array holding the heap items. The array is aligned to a cache line, and it has room for the
+ * d - 1 unused slots before the root.
+ *
+ * @param dh Pointer to the d-ary heap data structure.
+ * @param new_capacity The new capacity.
+ * @return true if the resizing was successful, false otherwise.
+ */
+static bool dh_resize(DHeap *dh, size_t new_capacity) {
+    // Allocate the new array, aligned_alloc needs a size that is a multiple of the alignment
+    size_t bytes = (new_capacity + ROOT(dh)) * sizeof(void *);
+    bytes = (bytes + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    void **new_items = aligned_alloc(CACHE_LINE_SIZE, bytes);
+    if (!new_items) {
+        return false;
+    }
+
+    // Copy the items to the new array.
+    if (dh->items) {
+        memcpy(new_items + ROOT(dh), dh->items + ROOT(dh), dh->size * sizeof(void *));
+    }
+
+    free(dh->items);
+    dh->items = new_items;
+    dh->capacity = new_capacity;
+
+    return true;
+}
+
+static void dh_swim_up(DHeap *dh, size_t pos) {
+    // Move the parents that are bigger than the item down, and place the item in the hole. The fields are copied to
+    // locals, since otherwise they are loaded again after each call of the comparison function.
+    void **items = dh->items;
+    COMPARE_FUNC compare = dh->compare;
+    void *item = items[pos];
+    while (pos != ROOT(dh) && compare(item, items[PARENT(dh, pos)]) < 0) {
+        items[pos] = items[PARENT(dh, pos)];
+        pos = PARENT(dh, pos);
+    }
+    items[pos] = item;
+}
+
+static void dh_sink_down(DHeap *dh, size_t pos) {
+    // Move the smallest children that are smaller than the item up, and place the item in the hole. The fields are
+    // copied to locals, since otherwise they are loaded again after each call of the comparison function.
+    void **items = dh->items;
+    COMPARE_FUNC compare = dh->compare;
+    size_t arity = dh->arity;
+    unsigned shift = dh->shift;
+    size_t end = ROOT(dh) + dh->size;
+    void *item = items[pos];
+    for (;;) {
+        size_t first = (pos - arity + 2) << shift;
+        if (first >= end) {
+            break;
+        }
+        // Find the smallest child with one pass over the children, which share a cache line
+        size_t last = first + arity < end ? first + arity : end;
+        size_t smallest = first;
+        for (size_t child = first + 1; child < last; child++) {
+            if (compare(items[child], items[smallest]) < 0) {
+                smallest = child;
+            }
+        }
+        // Check if the item is bigger than the smallest child
+        if (compare(item, items[smallest]) <= 0) {
+            // It is not, so the heap invariant holds
+            break;
+        }
+        items[pos] = items[smallest];
+        pos = smallest;
+    }
+    items[pos] = item;
+}
+
+static bool dh_is_heap(DHeap *dh) {
+    // Check if each item is not smaller than its parent
+    for (size_t i = ROOT(dh) + 1; i < ROOT(dh) + dh->size; i++) {
+        if (dh->compare(dh->items[PARENT(dh, i)], dh->items[i]) > 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool dh_init(DHeap *dh, COMPARE_FUNC compare, size_t arity) {
+    if (arity != 2 && arity != 4 && arity != DH_MAX_ARITY) {
+        return false;
+    }
+    dh->items = NULL;
+    dh->size = 0;
+    dh->arity = arity;
+    dh->shift = arity == 2 ? 1 : arity == 4 ? 2 : 3;
+    dh->compare = compare;
+
+    return dh_resize(dh, 1);
+}
+
+void dh_destroy(DHeap *dh) {
+    free(dh->items);
+}
+
+bool dh_is_empty(DHeap *dh) {
+    return dh->size == 0;
+}
+
+size_t dh_size(DHeap *dh) {
+    return dh->size;
+}
+
+bool dh_insert(DHeap *dh, void *item) {
+    if (!item) {
+        // NULL items cannot be added to the heap
+        return false;
+    }
+    if (dh->size == dh->capacity && !dh_resize(dh, 2 * dh->capacity)) {
+        // Could not resize the underlying array
+        return false;
+    }
+
+    // Set the item and move it to the correct position.
+    dh->items[ROOT(dh) + dh->size] = item;
+    dh_swim_up(dh, ROOT(dh) + dh->size);
+    dh->size++;
+
+    // Check the heap invariant
+    CHECK(dh->compare(dh->items[ROOT(dh)], item) <= 0);
+    CHECK_SAMPLED(dh_is_heap(dh));
+
+    return true;
+}
+
+void *dh_remove_min(DHeap *dh) {
+    if (dh->size == 0) {
+        // Heap is empty
+        return NULL;
+    }
+    dh->size--;
+    void *item = dh->items[ROOT(dh)];
+    if (dh->size > 0) {
+        // Place the element at the root and sink down as needed
+        dh->items[ROOT(dh)] = dh->items[ROOT(dh) + dh->size];
+        dh_sink_down(dh, ROOT(dh));
+        if (dh->size == dh->capacity / 4) {
+            // The array needs to be shrinked
+            dh_resize(dh, dh->capacity / 2);
+        }
+    }
+
+    // Check the heap invariant
+    CHECK(dh->size < 2 || dh->compare(dh->items[ROOT(dh)], dh->items[FIRST_CHILD(dh, ROOT(dh))]) <= 0);
+    CHECK_SAMPLED(dh_is_heap(dh));
+
+    return item;
+}
+
+void *dh_peek(DHeap *dh) {
+    return dh->size == 0 ? NULL : dh->items[ROOT(dh)];
+}
@@ -0,0 +1,513 @@
+#include "external_sort.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// The default number of bytes of memory used by an external sort
+#define EXTERNAL_SORT_DEFAULT_MEMORY (64 * 1024 * 1024)
+// The minimum number of bytes of the buffer of each run during a merge
+#define EXTERNAL_SORT_MIN_BUFFER (64 * 1024)
+// The maximum number of runs that are merged at once, which bounds the number of buffers and the depth of the loser
+// tree
+#define EXTERNAL_SORT_MAX_FAN_IN 256
+
+/**
+ * The state of an external sort.
+ */
+typedef struct {
+    /** The size in bytes of each record. */
+    size_t size;
+    /** The comparison function. */
+    COMPARE_FUNC compare;
+    /** The function that sorts the runs in memory. */
+    SORT_FUNC sort;
+    /** The directory where the runs are spilled. */
+    const char *tmp_dir;
+    /** The memory used to sort the runs and to buffer the merge. */
+    char *buffer;
+    /** The number of bytes of the memory. */
+    size_t memory;
+    /** The number of records in the memory, when the whole input fits in one run that is not spilled. */
+    size_t count;
+    /** The file descriptor of the temporary file that holds the spilled runs one after the other, or -1 if none. */
+    int file;
+    /** The offsets of the spilled runs in the file, in input order, followed by the end of the last run. */
+    off_t *runs;
+    /** The number of spilled runs. */
+    size_t nruns;
+    /** The capacity of the array of run offsets. */
+    size_t runs_capacity;
+} ExternalSort;
+
+/**
+ * A reader of a run that is being merged.
+ */
+typedef struct {
+    /** The file descriptor of the file that holds the run. */
+    int fd;
+    /** The offset in the file of the next bytes of the run to read. */
+    off_t offset;
+    /** The offset in the file of the end of the run. */
+    off_t end;
+    /** The buffer of the run. */
+    char *buffer;
+    /** The capacity in bytes of the buffer. */
+    size_t capacity;
+    /** The number of bytes in the buffer. Zero when the run is exhausted. */
+    size_t length;
+    /** The offset of the current record in the buffer. */
+    size_t position;
+} RunReader;
+
+/**
+ * Read from a file until the buffer is full or the end of the file is reached.
+ *
+ * @param fd The file descriptor.
+ * @param buffer The buffer.
+ * @param count The number of bytes to read.
+ * @param length Set to the number of bytes read.
+ * @return true if the read was successful, false otherwise.
+ */
+static bool read_full(int fd, char *buffer, size_t count, size_t *length) {
+    *length = 0;
+    while (*length < count) {
+        ssize_t bytes = read(fd, buffer + *length, count - *length);
+        if (bytes < 0 && errno == EINTR) {
+            continue;
+        } else if (bytes < 0) {
+            return false;
+        } else if (bytes == 0) {
+            break;
+        }
+        *length += (size_t) bytes;
+    }
+
+    return true;
+}
+
+/**
+ * Read from an offset of a file until the buffer is full or the end of the file is reached, without changing the file
+ * offset.
+ *
+ * @param fd The file descriptor.
+ * @param buffer The buffer.
+ * @param count The number of bytes to read.
+ * @param offset The offset in the file to read from.
+ * @param length Set to the number of bytes read.
+ * @return true if the read was successful, false otherwise.
+ */
+static bool pread_full(int fd, char *buffer, size_t count, off_t offset, size_t *length) {
+    *length = 0;
+    while (*length < count) {
+        ssize_t bytes = pread(fd, buffer + *length, count - *length, offset + (off_t) *length);
+        if (bytes < 0 && errno == EINTR) {
+            continue;
+        } else if (bytes < 0) {
+            return false;
+        } else if (bytes == 0) {
+            break;
+        }
+        *length += (size_t) bytes;
+    }
+
+    return true;
+}
+
+/**
+ * Write the whole buffer to a file.
+ *
+ * @param fd The file descriptor.
+ * @param buffer The buffer.
+ * @param count The number of bytes to write.
+ * @return true if the write was successful, false otherwise.
+ */
+static bool write_full(int fd, const char *buffer, size_t count) {
+    while (count > 0) {
+        ssize_t bytes = write(fd, buffer, count);
+        if (bytes < 0 && errno == EINTR) {
+            continue;
+        } else if (bytes < 0) {
+            return false;
+        }
+        buffer += bytes;
+        count -= (size_t) bytes;
+    }
+
+    return true;
+}
+
+/**
+ * Create an anonymous temporary file for the runs. The file is unlinked right away, so it is removed when it is closed.
+ *
+ * @param es Pointer to the external sort state.
+ * @return The file descriptor of the file, or -1 if it could not be created.
+ */
+static int es_create_run(const ExternalSort *es) {
+    static const char name[] = "/external-sort-XXXXXX";
+    size_t dir_length = strlen(es->tmp_dir);
+    char *path = malloc(dir_length + sizeof(name));
+    if (!path) {
+        return -1;
+    }
+    memcpy(path, es->tmp_dir, dir_length);
+    memcpy(path + dir_length, name, sizeof(name));
+    int fd = mkstemp(path);
+    if (fd >= 0) {
+        unlink(path);
+    }
+    free(path);
+
+    return fd;
+}
+
+/**
+ * Close a file, keeping the errno of the error that caused it to be closed.
+ *
+ * @param fd The file descriptor.
+ */
+static void es_close(int fd) {
+    int saved_errno = errno;
+    close(fd);
+    errno = saved_errno;
+}
+
+/**
+ * Initialize the external sort state.
+ *
+ * @param es Pointer to the external sort state.
+ * @param size The size in bytes of each record.
+ * @param compare Pointer to a function that compares two records.
+ * @param options The options of the sort, or NULL to use the defaults.
+ * @return true if the state was initialized successfully, false otherwise.
+ */
+static bool es_init(ExternalSort *es, size_t size, COMPARE_FUNC compare, const ExternalSortOptions *options) {
+    if (size == 0) {
+        errno = EINVAL;
+        return false;
+    }
+    es->size = size;
+    es->compare = compare;
+    es->sort = options && options->sort ? options->sort : quick_sort;
+    es->tmp_dir = options && options->tmp_dir ? options->tmp_dir : getenv("TMPDIR");
+    if (!es->tmp_dir || !*es->tmp_dir) {
+        es->tmp_dir = "/tmp";
+    }
+    // The memory must hold at least three buffers, so that at least two runs can be merged at once
+    size_t buffer = size > EXTERNAL_SORT_MIN_BUFFER ? size : EXTERNAL_SORT_MIN_BUFFER;
+    es->memory = options && options->memory ? options->memory : EXTERNAL_SORT_DEFAULT_MEMORY;
+    if (es->memory < 3 * buffer) {
+        es->memory = 3 * buffer;
+    }
+    es->buffer = malloc(es->memory);
+    es->count = 0;
+    es->file = -1;
+    es->runs = NULL;
+    es->nruns = 0;
+    es->runs_capacity = 0;
+
+    return es->buffer != NULL;
+}
+
+/**
+ * Destroy the external sort state, closing the file of the runs.
+ *
+ * @param es Pointer to the external sort state.
+ */
+static void es_destroy(ExternalSort *es) {
+    if (es->file >= 0) {
+        es_close(es->file);
+    }
+    free(es->runs);
+    free(es->buffer);
+}
+
+/**
+ * Add a run to the end of the list of spilled runs.
+ *
+ * @param es Pointer to the external sort state.
+ * @param end The offset in the file of the end of the run, which starts at the end of the previous run.
+ * @return true if the run was added, false otherwise.
+ */
+static bool es_add_run(ExternalSort *es, off_t end) {
+    // The array holds the offset of the start of each run, and the offset of the end of the last one
+    if (es->nruns + 2 > es->runs_capacity) {
+        size_t new_capacity = es->runs_capacity ? 2 * es->runs_capacity : 16;
+        off_t *new_runs = realloc(es->runs, new_capacity * sizeof(off_t));
+        if (!new_runs) {
+            return false;
+        }
+        es->runs = new_runs;
+        es->runs_capacity = new_capacity;
+    }
+    if (es->nruns == 0) {
+        es->runs[0] = 0;
+    }
+    es->runs[++es->nruns] = end;
+
+    return true;
+}
+
+/**
+ * Read the input in runs that fit in memory, sort each run, and spill it to the end of a temporary file. If the whole
+ * input fits in one run, the run is kept in memory.
+ *
+ * @param es Pointer to the external sort state.
+ * @param in_fd The file descriptor to read the records from.
+ * @return true if the runs were created, false otherwise.
+ */
+static bool es_split(ExternalSort *es, int in_fd) {
+    size_t capacity = es->memory / es->size * es->size;
+    posix_fadvise(in_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    for (;;) {
+        size_t length;
+        if (!read_full(in_fd, es->buffer, capacity, &length)) {
+            return false;
+        }
+        if (length % es->size != 0) {
+            errno = EINVAL;
+            return false;
+        }
+        if (length == 0) {
+            return true;
+        }
+        es->sort(es->buffer, length / es->size, es->size, es->compare);
+        if (length < capacity && es->nruns == 0) {
+            es->count = length / es->size;
+            return true;
+        }
+        // Spill the run
+        if (es->file < 0 && (es->file = es_create_run(es)) < 0) {
+            return false;
+        }
+        off_t start = es->nruns > 0 ? es->runs[es->nruns] : 0;
+        if (!write_full(es->file, es->buffer, length) || !es_add_run(es, start + (off_t) length)) {
+            return false;
+        }
+        if (length < capacity) {
+            return true;
+        }
+    }
+}
+
+/**
+ * Refill the buffer of a run reader.
+ *
+ * @param reader Pointer to the run reader.
+ * @param size The size in bytes of each record.
+ * @return true if the buffer was refilled, false otherwise.
+ */
+static bool run_reader_fill(RunReader *reader, size_t size) {
+    reader->position = 0;
+    size_t count = reader->capacity;
+    if ((off_t) count > reader->end - reader->offset) {
+        count = (size_t) (reader->end - reader->offset);
+    }
+    if (!pread_full(reader->fd, reader->buffer, count, reader->offset, &reader->length)) {
+        return false;
+    }
+    if (reader->length != count || reader->length % size != 0) {
+        errno = EIO;
+        return false;
+    }
+    reader->offset += (off_t) reader->length;
+
+    return true;
+}
+
+/**
+ * Check whether the current record of a run is placed before the current record of another run. Exhausted runs are
+ * placed after all the other runs, and equal records are placed in run order, so that the merge is stable.
+ *
+ * @param es Pointer to the external sort state.
+ * @param readers The run readers.
+ * @param first The index of the first run.
+ * @param second The index of the second run.
+ * @return true if the current record of the first run is placed first, false otherwise.
+ */
+static bool es_before(const ExternalSort *es, const RunReader *readers, size_t first, size_t second) {
+    if (readers[first].length == 0) {
+        return false;
+    } else if (readers[second].length == 0) {
+        return true;
+    }
+    int cmp = es->compare(readers[first].buffer + readers[first].position,
+                          readers[second].buffer + readers[second].position);
+
+    return cmp < 0 || (cmp == 0 && first < second);
+}
+
+/**
+ * Build a loser tree over the runs. Each internal node holds the run that lost the match at that node, and the
+ * winner of the subtree is returned.
+ *
+ * @param es Pointer to the external sort state.
+ * @param readers The run readers.
+ * @param tree The loser tree. Nodes 1 to k - 1 are internal nodes, and nodes k to 2k - 1 are the runs.
+ * @param k The number of runs.
+ * @param node The root of the subtree to build.
+ * @return The run that wins the subtree.
+ */
+static size_t loser_tree_build(const ExternalSort *es, const RunReader *readers, size_t *tree, size_t k, size_t node) {
+    if (node >= k) {
+        return node - k;
+    }
+    size_t left = loser_tree_build(es, readers, tree, k, 2 * node);
+    size_t right = loser_tree_build(es, readers, tree, k, 2 * node + 1);
+    if (es_before(es, readers, left, right)) {
+        tree[node] = right;
+        return left;
+    }
+    tree[node] = left;
+
+    return right;
+}
+
+/**
+ * Merge sorted runs to a file, using the memory of the external sort for the buffers.
+ *
+ * @param es Pointer to the external sort state.
+ * @param runs The offsets of the runs in the file of the runs, in input order, followed by the end of the last run.
+ * @param k The number of runs.
+ * @param out_fd The file descriptor to write the merged records to.
+ * @return true if the runs were merged, false otherwise.
+ */
+static bool es_merge(const ExternalSort *es, const off_t *runs, size_t k, int out_fd) {
+    size_t size = es->size;
+    RunReader *readers = malloc(k * sizeof(RunReader));
+    size_t *tree = malloc(k * sizeof(size_t));
+    if (!readers || !tree) {
+        free(readers);
+        free(tree);
+        return false;
+    }
+    // Split the memory to one buffer for each run and one for the output
+    size_t capacity = es->memory / (k + 1) / size * size;
+    bool ok = true;
+    for (size_t i = 0; i < k; i++) {
+        readers[i].fd = es->file;
+        readers[i].offset = runs[i];
+        readers[i].end = runs[i + 1];
+        readers[i].buffer = es->buffer + i * capacity;
+        readers[i].capacity = capacity;
+        ok = ok && run_reader_fill(&readers[i], size);
+    }
+    if (!ok) {
+        // Some readers were not filled, so the loser tree cannot be built
+        free(readers);
+        free(tree);
+        return false;
+    }
+    char *output = es->buffer + k * capacity;
+    size_t output_length = 0;
+    // Repeatedly output the winner and replay its matches up to the root
+    size_t winner = loser_tree_build(es, readers, tree, k, 1);
+    while (ok && readers[winner].length > 0) {
+        RunReader *reader = &readers[winner];
+        memcpy(output + output_length, reader->buffer + reader->position, size);
+        output_length += size;
+        if (output_length == capacity) {
+            ok = write_full(out_fd, output, output_length);
+            output_length = 0;
+        }
+        reader->position += size;
+        if (reader->position == reader->length) {
+            ok = ok && run_reader_fill(reader, size);
+        }
+        for (size_t node = (winner + k) / 2; node > 0; node /= 2) {
+            if (es_before(es, readers, tree[node], winner)) {
+                size_t temp = tree[node];
+                tree[node] = winner;
+                winner = temp;
+            }
+        }
+    }
+    ok = ok && write_full(out_fd, output, output_length);
+    free(readers);
+    free(tree);
+
+    return ok;
+}
+
+/**
+ * Merge the spilled runs to the output file. While there are more runs than can be merged at once, consecutive groups
+ * of runs are merged to longer runs, which are written one after the other to a new temporary file, so only two
+ * temporary files are open at any time.
+ *
+ * @param es Pointer to the external sort state.
+ * @param out_fd The file descriptor to write the sorted records to.
+ * @return true if the runs were merged, false otherwise.
+ */
+static bool es_merge_all(ExternalSort *es, int out_fd) {
+    if (es->nruns == 0) {
+        return write_full(out_fd, es->buffer, es->count * es->size);
+    }
+    size_t buffer = es->size > EXTERNAL_SORT_MIN_BUFFER ? es->size : EXTERNAL_SORT_MIN_BUFFER;
+    size_t fan_in = es->memory / buffer - 1;
+    if (fan_in > EXTERNAL_SORT_MAX_FAN_IN) {
+        fan_in = EXTERNAL_SORT_MAX_FAN_IN;
+    }
+    while (es->nruns > fan_in) {
+        int fd = es_create_run(es);
+        if (fd < 0) {
+            return false;
+        }
+        // The merged runs have the same lengths as their groups, so their offsets are updated in place. The offsets of
+        // a group come after the offset of its merged run, so they are read before they are overwritten.
+        size_t merged = 0;
+        for (size_t i = 0; i < es->nruns; i += fan_in) {
+            size_t k = es->nruns - i < fan_in ? es->nruns - i : fan_in;
+            off_t length = es->runs[i + k] - es->runs[i];
+            if (!es_merge(es, es->runs + i, k, fd)) {
+                es_close(fd);
+                return false;
+            }
+            es->runs[merged + 1] = es->runs[merged] + length;
+            merged++;
+        }
+        es_close(es->file);
+        es->file = fd;
+        es->nruns = merged;
+    }
+
+    return es_merge(es, es->runs, es->nruns, out_fd);
+}
+
+bool external_sort_fd(int in_fd, int out_fd, size_t size, COMPARE_FUNC compare, const ExternalSortOptions *options) {
+    ExternalSort es;
+    if (!es_init(&es, size, compare, options)) {
+        return false;
+    }
+    bool ok = es_split(&es, in_fd) && es_merge_all(&es, out_fd);
+    es_destroy(&es);
+
+    return ok;
+}
+
+bool external_sort_path(const char *in_path, const char *out_path, size_t size, COMPARE_FUNC compare,
+                        const ExternalSortOptions *options) {
+    ExternalSort es;
+    if (!es_init(&es, size, compare, options)) {
+        return false;
+    }
+    // Read the whole input before the output is opened, as they can be the same file
+    int in_fd = open(in_path, O_RDONLY);
+    if (in_fd < 0) {
+        es_destroy(&es);
+        return false;
+    }
+    bool ok = es_split(&es, in_fd);
+    es_close(in_fd);
+    if (ok) {
+        int out_fd = open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        ok = out_fd >= 0 && es_merge_all(&es, out_fd);
+        if (out_fd >= 0 && close(out_fd) < 0) {
+            ok = false;
+        }
+    }
+    es_destroy(&es);
+
+    return ok;
+}
@@ -0,0 +1,293 @@
+#include "iheap.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PARENT(x) (((x) - 1) / 2)
+#define LEFT_CHILD(x) ((2 * (x)) + 1)
+#define RIGHT_CHILD(x) ((2 * (x)) + 2)
+
+// The position of the handles that are not in the heap
+#define NOT_IN_HEAP SIZE_MAX
+
+/**
+ * Resize the underlying arrays, so that they can hold the handles up to the new capacity.
+ *
+ * @param ih Pointer to the indexed binary heap data structure.
+ * @param new_capacity The new capacity, which must be larger than the current capacity.
+ * @return true if the resizing was successful, false otherwise.
+ */
+static bool ih_resize(IHeap *ih, size_t new_capacity) {
+    if (new_capacity > SIZE_MAX / sizeof(size_t) || new_capacity > SIZE_MAX / sizeof(void *)) {
+        // The sizes of the arrays would overflow
+        return false;
+    }
+
+    // Allocate the new arrays
+    size_t *new_heap = malloc(new_capacity * sizeof(size_t));
+    size_t *new_positions = malloc(new_capacity * sizeof(size_t));
+    void **new_items = malloc(new_capacity * sizeof(void *));
+    if (!new_heap || !new_positions || !new_items) {
+        free(new_heap);
+        free(new_positions);
+        free(new_items);
+        return false;
+    }
+
+    // Copy the heap and the handles to the new arrays, the new handles are not in the heap
+    if (ih->capacity > 0) {
+        memcpy(new_heap, ih->heap, ih->size * sizeof(size_t));
+        memcpy(new_positions, ih->positions, ih->capacity * sizeof(size_t));
+        memcpy(new_items, ih->items, ih->capacity * sizeof(void *));
+    }
+    for (size_t i = ih->capacity; i < new_capacity; i++) {
+        new_positions[i] = NOT_IN_HEAP;
+        new_items[i] = NULL;
+    }
+
+    free(ih->heap);
+    free(ih->positions);
+    free(ih->items);
+    ih->heap = new_heap;
+    ih->positions = new_positions;
+    ih->items = new_items;
+    ih->capacity = new_capacity;
+
+    return true;
+}
+
+/**
+ * Compare the items at two heap positions.
+ *
+ * @param ih Pointer to the indexed binary heap data structure.
+ * @param i The first position.
+ * @param j The second position.
+ * @return The result of the comparison function.
+ */
+static int ih_compare(IHeap *ih, size_t i, size_t j) {
+    return ih->compare(ih->items[ih->heap[i]], ih->items[ih->heap[j]]);
+}
+
+/**
+ * Swap the items at two heap positions, and update their positions.
+ *
+ * @param ih Pointer to the indexed binary heap data structure.
+ * @param i The first position.
+ * @param j The second position.
+ */
+static void ih_swap(IHeap *ih, size_t i, size_t j) {
+    size_t temp = ih->heap[i];
+    ih->heap[i] = ih->heap[j];
+    ih->heap[j] = temp;
+    ih->positions[ih->heap[i]] = i;
+    ih->positions[ih->heap[j]] = j;
+}
+
+static void ih_swim_up(IHeap *ih, size_t pos) {
+    // Check if the item is smaller than its parent
+    while (pos != 0 && ih_compare(ih, pos, PARENT(pos)) < 0) {
+        // It is smaller, so swap them
+        ih_swap(ih, pos, PARENT(pos));
+
+        // Check the new parent of the item
+        pos = PARENT(pos);
+    }
+}
+
+static void ih_sink_down(IHeap *ih, size_t pos) {
+    while (LEFT_CHILD(pos) < ih->size) {
+        // Find the smallest child
+        size_t smallest = LEFT_CHILD(pos);
+        if (RIGHT_CHILD(pos) < ih->size && ih_compare(ih, RIGHT_CHILD(pos), smallest) < 0) {
+            smallest = RIGHT_CHILD(pos);
+        }
+        // Check if the item is bigger than the smallest child
+        if (ih_compare(ih, pos, smallest) <= 0) {
+            // It is not, so the heap invariant holds
+            return;
+        }
+        // It is bigger, so swap them
+        ih_swap(ih, pos, smallest);
+
+        // Check the new child
+        pos = smallest;
+    }
+}
+
+static bool ih_is_heap(IHeap *ih, size_t pos) {
+    if (pos >= ih->size) {
+        return true;
+    }
+
+    // Check if the position map points back to the item
+    if (ih->positions[ih->heap[pos]] != pos) {
+        return false;
+    }
+    // Check if item is smaller than its children
+    if (LEFT_CHILD(pos) < ih->size && ih_compare(ih, pos, LEFT_CHILD(pos)) > 0) {
+        return false;
+    }
+    if (RIGHT_CHILD(pos) < ih->size && ih_compare(ih, pos, RIGHT_CHILD(pos)) > 0) {
+        return false;
+    }
+
+    // Recursively check the subtrees
+    return ih_is_heap(ih, LEFT_CHILD(pos)) && ih_is_heap(ih, RIGHT_CHILD(pos));
+}
+
+bool ih_init(IHeap *ih, COMPARE_FUNC compare) {
+    ih->heap = NULL;
+    ih->positions = NULL;
+    ih->items = NULL;
+    ih->capacity = 0;
+    ih->size = 0;
+    ih->compare = compare;
+
+    return ih_resize(ih, 1);
+}
+
+void ih_destroy(IHeap *ih) {
+    free(ih->heap);
+    free(ih->positions);
+    free(ih->items);
+}
+
+bool ih_is_empty(IHeap *ih) {
+    return ih->size == 0;
+}
+
+size_t ih_size(IHeap *ih) {
+    return ih->size;
+}
+
+bool ih_contains(IHeap *ih, size_t handle) {
+    return handle < ih->capacity && ih->positions[handle] != NOT_IN_HEAP;
+}
+
+void *ih_get(IHeap *ih, size_t handle) {
+    return ih_contains(ih, handle) ? ih->items[handle] : NULL;
+}
+
+bool ih_insert(IHeap *ih, size_t handle, void *item) {
+    if (!item || handle == NOT_IN_HEAP || ih_contains(ih, handle)) {
+        // NULL items cannot be added to the heap, and each handle can be added once
+        return false;
+    }
+    if (handle >= ih->capacity) {
+        size_t new_capacity = 2 * ih->capacity > handle ? 2 * ih->capacity : handle + 1;
+        if (!ih_resize(ih, new_capacity)) {
+            // Could not resize the underlying arrays
+            return false;
+        }
+    }
+
+    // Set the item and move it to the correct position.
+    ih->items[handle] = item;
+    ih->heap[ih->size] = handle;
+    ih->positions[handle] = ih->size;
+    ih_swim_up(ih, ih->size);
+    ih->size++;
+
+    // Check the heap invariant
+    CHECK(ih->heap[ih->positions[handle]] == handle);
+    CHECK_SAMPLED(ih_is_heap(ih, 0));
+
+    return true;
+}
+
+bool ih_decrease_key(IHeap *ih, size_t handle, void *item) {
+    if (!item || !ih_contains(ih, handle)) {
+        return false;
+    }
+    void *old = ih->items[handle];
+    if (item != old && ih->compare(item, old) > 0) {
+        // A different item must not be bigger
+        return false;
+    }
+
+    // A smaller item can only move up. The key of the same item was changed in place and cannot be compared to the
+    // old one, so it is also moved down in case it was increased.
+    ih->items[handle] = item;
+    ih_swim_up(ih, ih->positions[handle]);
+    if (item == old) {
+        ih_sink_down(ih, ih->positions[handle]);
+    }
+
+    // Check the heap invariant
+    CHECK(ih->heap[ih->positions[handle]] == handle);
+    CHECK_SAMPLED(ih_is_heap(ih, 0));
+
+    return true;
+}
+
+bool ih_increase_key(IHeap *ih, size_t handle, void *item) {
+    if (!item || !ih_contains(ih, handle)) {
+        return false;
+    }
+    void *old = ih->items[handle];
+    if (item != old && ih->compare(item, old) < 0) {
+        // A different item must not be smaller
+        return false;
+    }
+
+    // A bigger item can only move down. The key of the same item was changed in place and cannot be compared to the
+    // old one, so it is also moved up in case it was decreased.
+    ih->items[handle] = item;
+    ih_sink_down(ih, ih->positions[handle]);
+    if (item == old) {
+        ih_swim_up(ih, ih->positions[handle]);
+    }
+
+    // Check the heap invariant
+    CHECK(ih->heap[ih->positions[handle]] == handle);
+    CHECK_SAMPLED(ih_is_heap(ih, 0));
+
+    return true;
+}
+
+void *ih_remove(IHeap *ih, size_t handle) {
+    if (!ih_contains(ih, handle)) {
+        return NULL;
+    }
+    size_t pos = ih->positions[handle];
+    ih->size--;
+    if (pos != ih->size) {
+        // Place the last item at the position of the removed one, and move it up or down as needed
+        ih_swap(ih, pos, ih->size);
+        ih_swim_up(ih, pos);
+        ih_sink_down(ih, pos);
+    }
+    void *item = ih->items[handle];
+    ih->positions[handle] = NOT_IN_HEAP;
+    ih->items[handle] = NULL;
+
+    // Check the heap invariant
+    CHECK(ih->size < 2 || ih_compare(ih, 0, LEFT_CHILD(0)) <= 0);
+    CHECK_SAMPLED(ih_is_heap(ih, 0));
+
+    return item;
+}
+
+void *ih_remove_min(IHeap *ih, size_t *handle) {
+    if (ih->size == 0) {
+        // Heap is empty
+        return NULL;
+    }
+    if (handle) {
+        *handle = ih->heap[0];
+    }
+
+    return ih_remove(ih, ih->heap[0]);
+}
+
+void *ih_peek(IHeap *ih, size_t *handle) {
+    if (ih->size == 0) {
+        return NULL;
+    }
+    if (handle) {
+        *handle = ih->heap[0];
+    }
+
+    return ih->items[ih->heap[0]];
+}
@@ -0,0 +1,180 @@
+#include "kheap.h"
+#include "common.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// The size of a cache line in bytes, to which the children of each node are aligned
+#define CACHE_LINE_SIZE 64
+// The number of children of each node, which fill a cache line with 16 byte items
+#define ARITY 4
+
+// The root is stored at index ARITY - 1, so the children of each node start at an index that is aligned to the arity
+#define ROOT (ARITY - 1)
+#define FIRST_CHILD(x) (ARITY * ((x) - ARITY + 2))
+#define PARENT(x) ((x) / ARITY + ARITY - 2)
+
+/**
+ * Resize the underlying array holding the heap items. The array is aligned to a cache line, and it has room for the
+ * unused slots before the root.
+ *
+ * @param kh Pointer to the keyed heap data structure.
+ * @param new_capacity The new capacity.
+ * @return true if the resizing was successful, false otherwise.
+ */
+static bool kh_resize(KHeap *kh, size_t new_capacity) {
+    // Allocate the new array, aligned_alloc needs a size that is a multiple of the alignment
+    size_t bytes = (new_capacity + ROOT) * sizeof(KHeapItem);
+    bytes = (bytes + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    KHeapItem *new_items = aligned_alloc(CACHE_LINE_SIZE, bytes);
+    if (!new_items) {
+        return false;
+    }
+
+    // Copy the items to the new array.
+    if (kh->items) {
+        memcpy(new_items + ROOT, kh->items + ROOT, kh->size * sizeof(KHeapItem));
+    }
+
+    free(kh->items);
+    kh->items = new_items;
+    kh->capacity = new_capacity;
+
+    return true;
+}
+
+static void kh_swim_up(KHeap *kh, size_t pos) {
+    // Move the parents that are bigger than the item down, and place the item in the hole
+    KHeapItem *items = kh->items;
+    KHeapItem item = items[pos];
+    while (pos != ROOT && item.key < items[PARENT(pos)].key) {
+        items[pos] = items[PARENT(pos)];
+        pos = PARENT(pos);
+    }
+    items[pos] = item;
+}
+
+static void kh_sink_down(KHeap *kh, size_t pos) {
+    // Move the smallest children that are smaller than the item up, and place the item in the hole
+    KHeapItem *items = kh->items;
+    size_t end = ROOT + kh->size;
+    KHeapItem item = items[pos];
+    for (;;) {
+        size_t first = FIRST_CHILD(pos);
+        if (first >= end) {
+            break;
+        }
+        // Find the smallest child with one pass over the children, which fill a cache line
+        size_t smallest = first;
+        if (first + ARITY <= end) {
+            // Compare the children in pairs, so that the comparisons do not depend on each other
+            size_t left = items[first + 1].key < items[first].key ? first + 1 : first;
+            size_t right = items[first + 3].key < items[first + 2].key ? first + 3 : first + 2;
+            smallest = items[right].key < items[left].key ? right : left;
+        } else {
+            for (size_t child = first + 1; child < end; child++) {
+                if (items[child].key < items[smallest].key) {
+                    smallest = child;
+                }
+            }
+        }
+        // Check if the item is bigger than the smallest child
+        if (item.key <= items[smallest].key) {
+            // It is not, so the heap invariant holds
+            break;
+        }
+        items[pos] = items[smallest];
+        pos = smallest;
+    }
+    items[pos] = item;
+}
+
+static bool kh_is_heap(KHeap *kh) {
+    // Check if each item is not smaller than its parent
+    for (size_t i = ROOT + 1; i < ROOT + kh->size; i++) {
+        if (kh->items[PARENT(i)].key > kh->items[i].key) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool kh_init(KHeap *kh) {
+    kh->items = NULL;
+    kh->size = 0;
+
+    return kh_resize(kh, 1);
+}
+
+void kh_destroy(KHeap *kh) {
+    free(kh->items);
+}
+
+bool kh_is_empty(KHeap *kh) {
+    return kh->size == 0;
+}
+
+size_t kh_size(KHeap *kh) {
+    return kh->size;
+}
+
+bool kh_insert(KHeap *kh, uint64_t key, void *payload) {
+    if (!payload) {
+        // NULL payloads cannot be added to the heap
+        return false;
+    }
+    if (kh->size == kh->capacity && !kh_resize(kh, 2 * kh->capacity)) {
+        // Could not resize the underlying array
+        return false;
+    }
+
+    // Set the item and move it to the correct position.
+    kh->items[ROOT + kh->size] = (KHeapItem) {key, payload};
+    kh_swim_up(kh, ROOT + kh->size);
+    kh->size++;
+
+    // Check the heap invariant
+    CHECK(kh->items[ROOT].key <= key);
+    CHECK_SAMPLED(kh_is_heap(kh));
+
+    return true;
+}
+
+void *kh_remove_min(KHeap *kh, uint64_t *key) {
+    if (kh->size == 0) {
+        // Heap is empty
+        return NULL;
+    }
+    kh->size--;
+    KHeapItem item = kh->items[ROOT];
+    if (kh->size > 0) {
+        // Place the element at the root and sink down as needed
+        kh->items[ROOT] = kh->items[ROOT + kh->size];
+        kh_sink_down(kh, ROOT);
+        if (kh->size == kh->capacity / 4) {
+            // The array needs to be shrinked
+            kh_resize(kh, kh->capacity / 2);
+        }
+    }
+    if (key) {
+        *key = item.key;
+    }
+
+    // Check the heap invariant
+    CHECK(kh->size == 0 || kh->items[ROOT].key >= item.key);
+    CHECK_SAMPLED(kh_is_heap(kh));
+
+    return item.payload;
+}
+
+void *kh_peek(KHeap *kh, uint64_t *key) {
+    if (kh->size == 0) {
+        return NULL;
+    }
+    if (key) {
+        *key = kh->items[ROOT].key;
+    }
+
+    return kh->items[ROOT].payload;
+}
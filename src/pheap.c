@@ -0,0 +1,238 @@
+#include "pheap.h"
+
+#include <stdlib.h>
+
+/**
+ * Link two trees, by making the root with the bigger item the leftmost child of the other root.
+ *
+ * @param ph Pointer to the pairing heap data structure.
+ * @param first The root of the first tree.
+ * @param second The root of the second tree.
+ * @return The root of the linked tree. Its sibling links are not set.
+ */
+static PHeapNode *ph_link(PHeap *ph, PHeapNode *first, PHeapNode *second) {
+    if (ph->compare(second->item, first->item) < 0) {
+        PHeapNode *temp = first;
+        first = second;
+        second = temp;
+    }
+    second->next = first->child;
+    if (first->child) {
+        first->child->prev = second;
+    }
+    second->prev = first;
+    first->child = second;
+
+    return first;
+}
+
+/**
+ * Merge a list of siblings to one tree. The siblings are linked in pairs from left to right, and then the pairs are
+ * linked from right to left.
+ *
+ * @param ph Pointer to the pairing heap data structure.
+ * @param first The leftmost sibling.
+ * @return The root of the merged tree, or NULL if the list is empty.
+ */
+static PHeapNode *ph_merge_pairs(PHeap *ph, PHeapNode *first) {
+    // Link the pairs, and keep them in a list that is linked in reverse with the previous pointers
+    PHeapNode *pairs = NULL;
+    while (first) {
+        PHeapNode *second = first->next;
+        if (!second) {
+            first->prev = pairs;
+            pairs = first;
+            break;
+        }
+        PHeapNode *rest = second->next;
+        PHeapNode *linked = ph_link(ph, first, second);
+        linked->prev = pairs;
+        pairs = linked;
+        first = rest;
+    }
+    if (!pairs) {
+        return NULL;
+    }
+
+    // Link the pairs from right to left
+    PHeapNode *root = pairs;
+    pairs = pairs->prev;
+    while (pairs) {
+        PHeapNode *prev = pairs->prev;
+        root = ph_link(ph, pairs, root);
+        pairs = prev;
+    }
+    root->next = NULL;
+    root->prev = NULL;
+
+    return root;
+}
+
+static PHeapNode *ph_parent(PHeapNode *node) {
+    // Move to the leftmost sibling, whose previous node is the parent
+    while (node->prev && node->prev->child != node) {
+        node = node->prev;
+    }
+
+    return node->prev;
+}
+
+static bool ph_is_heap(PHeap *ph) {
+    // Visit the nodes in preorder without a stack, by climbing back with the previous pointers
+    PHeapNode *node = ph->root;
+    while (node) {
+        // Check if the children of the node are not smaller than it
+        for (PHeapNode *child = node->child; child; child = child->next) {
+            if (ph->compare(node->item, child->item) > 0) {
+                return false;
+            }
+        }
+        if (node->child) {
+            node = node->child;
+        } else {
+            while (node && !node->next) {
+                node = ph_parent(node);
+            }
+            node = node ? node->next : NULL;
+        }
+    }
+
+    return true;
+}
+
+bool ph_init(PHeap *ph, COMPARE_FUNC compare) {
+    ph->root = NULL;
+    ph->size = 0;
+    ph->free_nodes = NULL;
+    ph->compare = compare;
+
+    return true;
+}
+
+void ph_destroy(PHeap *ph) {
+    // Free the tree without a stack, by rotating the leftmost children to the sibling lists
+    PHeapNode *node = ph->root;
+    while (node) {
+        if (node->child) {
+            PHeapNode *child = node->child;
+            node->child = child->next;
+            child->next = node;
+            node = child;
+        } else {
+            PHeapNode *next = node->next;
+            free(node);
+            node = next;
+        }
+    }
+    while (ph->free_nodes) {
+        PHeapNode *next = ph->free_nodes->next;
+        free(ph->free_nodes);
+        ph->free_nodes = next;
+    }
+}
+
+bool ph_is_empty(PHeap *ph) {
+    return ph->size == 0;
+}
+
+size_t ph_size(PHeap *ph) {
+    return ph->size;
+}
+
+bool ph_insert(PHeap *ph, void *item, PHeapNode **node) {
+    if (!item) {
+        // NULL items cannot be added to the heap
+        return false;
+    }
+    // Reuse a node of a removed item if possible
+    PHeapNode *new_node = ph->free_nodes;
+    if (new_node) {
+        ph->free_nodes = new_node->next;
+    } else {
+        new_node = malloc(sizeof(PHeapNode));
+        if (!new_node) {
+            return false;
+        }
+    }
+    new_node->item = item;
+    new_node->child = NULL;
+    new_node->next = NULL;
+    new_node->prev = NULL;
+    if (node) {
+        *node = new_node;
+    }
+
+    // Link the node with the root
+    ph->root = ph->root ? ph_link(ph, ph->root, new_node) : new_node;
+    ph->size++;
+
+    // Check the heap invariant
+    CHECK(ph->compare(ph->root->item, item) <= 0);
+    CHECK_SAMPLED(ph_is_heap(ph));
+
+    return true;
+}
+
+bool ph_decrease_key(PHeap *ph, PHeapNode *node, void *item) {
+    if (!item || ph->compare(item, node->item) > 0) {
+        return false;
+    }
+    node->item = item;
+    if (node != ph->root) {
+        // Cut the subtree of the node from its parent, and link it with the root
+        if (node->prev->child == node) {
+            node->prev->child = node->next;
+        } else {
+            node->prev->next = node->next;
+        }
+        if (node->next) {
+            node->next->prev = node->prev;
+        }
+        node->next = NULL;
+        node->prev = NULL;
+        ph->root = ph_link(ph, ph->root, node);
+    }
+
+    // Check the heap invariant
+    CHECK(ph->compare(ph->root->item, item) <= 0);
+    CHECK_SAMPLED(ph_is_heap(ph));
+
+    return true;
+}
+
+void ph_meld(PHeap *ph, PHeap *other) {
+    if (other->root) {
+        ph->root = ph->root ? ph_link(ph, ph->root, other->root) : other->root;
+        ph->size += other->size;
+        other->root = NULL;
+        other->size = 0;
+    }
+
+    // Check the heap invariant
+    CHECK_SAMPLED(ph_is_heap(ph));
+}
+
+void *ph_remove_min(PHeap *ph) {
+    if (ph->size == 0) {
+        // Heap is empty
+        return NULL;
+    }
+    PHeapNode *root = ph->root;
+    void *item = root->item;
+    ph->root = ph_merge_pairs(ph, root->child);
+    ph->size--;
+
+    // Keep the node for the next insert
+    root->next = ph->free_nodes;
+    ph->free_nodes = root;
+
+    // Check the heap invariant
+    CHECK(ph->size == 0 || ph->compare(item, ph->root->item) <= 0);
+    CHECK_SAMPLED(ph_is_heap(ph));
+
+    return item;
+}
+
+void *ph_peek(PHeap *ph) {
+    return ph->size == 0 ? NULL : ph->root->item;
+}
@@ -0,0 +1,190 @@
+#include "rheap.h"
+#include "common.h"
+
+#include <stdlib.h>
+
+/**
+ * Return the bucket of a key, which is the number of the highest bit in which the key differs from the last removed
+ * key, counting from one, or zero if the keys are equal.
+ *
+ * @param key The key.
+ * @param last The last removed key.
+ * @return The bucket of the key.
+ */
+static size_t rh_bucket(uint64_t key, uint64_t last) {
+    uint64_t diff = key ^ last;
+#if defined(__GNUC__)
+    return diff == 0 ? 0 : 64 - (size_t) __builtin_clzll(diff);
+#else
+    size_t bucket = 0;
+    while (diff) {
+        bucket++;
+        diff >>= 1;
+    }
+
+    return bucket;
+#endif
+}
+
+/**
+ * Make sure that a bucket has room for a number of items.
+ *
+ * @param bucket Pointer to the bucket.
+ * @param capacity The number of items.
+ * @return true if the bucket has room for the items, false if the memory could not be allocated.
+ */
+static bool rh_reserve(RHeapBucket *bucket, size_t capacity) {
+    if (capacity <= bucket->capacity) {
+        return true;
+    }
+    size_t new_capacity = 2 * bucket->capacity > capacity ? 2 * bucket->capacity : capacity;
+    RHeapItem *new_items = realloc(bucket->items, new_capacity * sizeof(RHeapItem));
+    if (!new_items) {
+        return false;
+    }
+    bucket->items = new_items;
+    bucket->capacity = new_capacity;
+
+    return true;
+}
+
+/**
+ * Make sure that the bucket of the keys that are equal to the last removed key is not empty, by distributing the first
+ * non empty bucket to the lower buckets. The heap must not be empty.
+ *
+ * @param rh Pointer to the radix heap data structure.
+ * @return true if the bucket is not empty, false if the memory could not be allocated, in which case the heap is not
+ * modified.
+ */
+static bool rh_refill(RHeap *rh) {
+    if (rh->buckets[0].size > 0) {
+        return true;
+    }
+    size_t i = 1;
+    while (rh->buckets[i].size == 0) {
+        i++;
+    }
+    RHeapBucket *bucket = &rh->buckets[i];
+
+    // The minimum key of the bucket becomes the last removed key
+    uint64_t last = bucket->items[0].key;
+    for (size_t j = 1; j < bucket->size; j++) {
+        if (bucket->items[j].key < last) {
+            last = bucket->items[j].key;
+        }
+    }
+
+    // Make room for the items in the lower buckets before moving any of them. The keys of the bucket agree with each
+    // other from bit i - 1 up, so they all move to lower buckets.
+    size_t counts[RH_NUM_BUCKETS] = {0};
+    for (size_t j = 0; j < bucket->size; j++) {
+        counts[rh_bucket(bucket->items[j].key, last)]++;
+    }
+    for (size_t b = 0; b < i; b++) {
+        if (!rh_reserve(&rh->buckets[b], counts[b])) {
+            return false;
+        }
+    }
+
+    // Move the items. The higher buckets stay the same, since the new last key agrees with the old one from bit i up.
+    for (size_t j = 0; j < bucket->size; j++) {
+        RHeapBucket *target = &rh->buckets[rh_bucket(bucket->items[j].key, last)];
+        target->items[target->size++] = bucket->items[j];
+    }
+    bucket->size = 0;
+    rh->last = last;
+
+    return true;
+}
+
+static bool rh_is_heap(RHeap *rh) {
+    // Check if each item is in the bucket of its key, which also means that it is not smaller than the last removed key
+    size_t size = 0;
+    for (size_t b = 0; b < RH_NUM_BUCKETS; b++) {
+        for (size_t j = 0; j < rh->buckets[b].size; j++) {
+            uint64_t key = rh->buckets[b].items[j].key;
+            if (key < rh->last || rh_bucket(key, rh->last) != b) {
+                return false;
+            }
+        }
+        size += rh->buckets[b].size;
+    }
+
+    return size == rh->size;
+}
+
+bool rh_init(RHeap *rh) {
+    for (size_t b = 0; b < RH_NUM_BUCKETS; b++) {
+        rh->buckets[b].items = NULL;
+        rh->buckets[b].capacity = 0;
+        rh->buckets[b].size = 0;
+    }
+    rh->last = 0;
+    rh->size = 0;
+
+    return true;
+}
+
+void rh_destroy(RHeap *rh) {
+    for (size_t b = 0; b < RH_NUM_BUCKETS; b++) {
+        free(rh->buckets[b].items);
+    }
+}
+
+bool rh_is_empty(RHeap *rh) {
+    return rh->size == 0;
+}
+
+size_t rh_size(RHeap *rh) {
+    return rh->size;
+}
+
+bool rh_insert(RHeap *rh, uint64_t key, void *payload) {
+    if (!payload || key < rh->last) {
+        // NULL payloads and keys smaller than the last removed key cannot be added to the heap
+        return false;
+    }
+    RHeapBucket *bucket = &rh->buckets[rh_bucket(key, rh->last)];
+    if (!rh_reserve(bucket, bucket->size + 1)) {
+        // Could not resize the bucket
+        return false;
+    }
+    bucket->items[bucket->size++] = (RHeapItem) {key, payload};
+    rh->size++;
+
+    // Check the heap invariant
+    CHECK_SAMPLED(rh_is_heap(rh));
+
+    return true;
+}
+
+void *rh_remove_min(RHeap *rh, uint64_t *key) {
+    if (rh->size == 0 || !rh_refill(rh)) {
+        // Heap is empty, or the memory could not be allocated
+        return NULL;
+    }
+    RHeapBucket *bucket = &rh->buckets[0];
+    RHeapItem item = bucket->items[--bucket->size];
+    rh->size--;
+    if (key) {
+        *key = item.key;
+    }
+
+    // Check the heap invariant
+    CHECK(item.key == rh->last);
+    CHECK_SAMPLED(rh_is_heap(rh));
+
+    return item.payload;
+}
+
+void *rh_peek(RHeap *rh, uint64_t *key) {
+    if (rh->size == 0 || !rh_refill(rh)) {
+        return NULL;
+    }
+    RHeapBucket *bucket = &rh->buckets[0];
+    if (key) {
+        *key = bucket->items[bucket->size - 1].key;
+    }
+
+    return bucket->items[bucket->size - 1].payload;
+}
@@ -0,0 +1,802 @@
+#include "sort_network.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SORT_NETWORK_X86 1
+#else
+#define SORT_NETWORK_X86 0
+#endif
+
+/*
+ * The networks sort SORT_NETWORK_MAX keys, with the unused keys padded with the maximum value. They are bitonic
+ * networks written so that every comparator places the smaller key at the lower index. For each block size k, a flip
+ * step compares each key i with the key i ^ (k - 1), and is followed by half-cleaner steps that compare each key i
+ * with the key i ^ d, for d from k / 4 down to 1.
+ *
+ * The vector versions keep the keys in registers. A step whose partners are in the same register permutes the register
+ * and blends the minimum and the maximum of the two. A step whose partners are in different registers compares whole
+ * registers, reversing the second one for flip steps.
+ */
+
+/**
+ * Run the bitonic network over registers.
+ *
+ * @param v The registers.
+ * @param registers The number of registers.
+ * @param lanes The number of keys in each register.
+ * @param step The function that runs an in-register step, given the register and the distance of the partners.
+ * @param flip The function that runs a flip step between two registers.
+ * @param half The function that runs a half-cleaner step between two registers.
+ */
+#define SORT_NETWORK_RUN(v, registers, lanes, step, flip, half) \
+    for (size_t k = 2; k <= SORT_NETWORK_MAX; k *= 2) { \
+        if (k <= (lanes)) { \
+            for (size_t r = 0; r < (registers); r++) { \
+                v[r] = step(v[r], (int) (k - 1)); \
+            } \
+        } else { \
+            size_t group = k / (lanes); \
+            for (size_t r = 0; r < (registers); r++) { \
+                if (r % group < group / 2) { \
+                    flip(&v[r], &v[r ^ (group - 1)]); \
+                } \
+            } \
+        } \
+        for (size_t d = k / 4; d > 0; d /= 2) { \
+            if (d < (lanes)) { \
+                for (size_t r = 0; r < (registers); r++) { \
+                    v[r] = step(v[r], (int) d); \
+                } \
+            } else { \
+                size_t group = d / (lanes); \
+                for (size_t r = 0; r < (registers); r++) { \
+                    if (!(r & group)) { \
+                        half(&v[r], &v[r | group]); \
+                    } \
+                } \
+            } \
+        } \
+    }
+
+/**
+ * Run a step of the network over 32-bit keys in scalar code.
+ *
+ * @param keys The keys.
+ * @param x The partner of each key i is the key i ^ x.
+ */
+static void scalar_step_32(int32_t *keys, size_t x) {
+    for (size_t i = 0; i < SORT_NETWORK_MAX; i++) {
+        size_t j = i ^ x;
+        if (i < j) {
+            int32_t a = keys[i];
+            int32_t b = keys[j];
+            keys[i] = a < b ? a : b;
+            keys[j] = a < b ? b : a;
+        }
+    }
+}
+
+/**
+ * Run a step of the network over 64-bit keys in scalar code.
+ *
+ * @param keys The keys.
+ * @param x The partner of each key i is the key i ^ x.
+ */
+static void scalar_step_64(int64_t *keys, size_t x) {
+    for (size_t i = 0; i < SORT_NETWORK_MAX; i++) {
+        size_t j = i ^ x;
+        if (i < j) {
+            int64_t a = keys[i];
+            int64_t b = keys[j];
+            keys[i] = a < b ? a : b;
+            keys[j] = a < b ? b : a;
+        }
+    }
+}
+
+/**
+ * Sort 32-bit keys with the network in scalar code.
+ *
+ * @param keys The keys.
+ */
+static void scalar_sort_32(int32_t *keys) {
+    for (size_t k = 2; k <= SORT_NETWORK_MAX; k *= 2) {
+        scalar_step_32(keys, k - 1);
+        for (size_t d = k / 4; d > 0; d /= 2) {
+            scalar_step_32(keys, d);
+        }
+    }
+}
+
+/**
+ * Sort 64-bit keys with the network in scalar code.
+ *
+ * @param keys The keys.
+ */
+static void scalar_sort_64(int64_t *keys) {
+    for (size_t k = 2; k <= SORT_NETWORK_MAX; k *= 2) {
+        scalar_step_64(keys, k - 1);
+        for (size_t d = k / 4; d > 0; d /= 2) {
+            scalar_step_64(keys, d);
+        }
+    }
+}
+
+/**
+ * Merge two sorted arrays of 32-bit keys without branches on the keys. The keys are compared after they are xored
+ * with the bias, so that unsigned keys can be merged as signed ones.
+ *
+ * @param dest The destination array. The right array may be the end of it.
+ * @param left The left array.
+ * @param n1 The number of elements in the left array.
+ * @param right The right array.
+ * @param n2 The number of elements in the right array.
+ * @param bias The value that the keys are xored with before they are compared.
+ */
+static void scalar_merge_32(int32_t *dest, const int32_t *left, size_t n1, const int32_t *right, size_t n2,
+                            int32_t bias) {
+    size_t i = 0;
+    size_t j = 0;
+    size_t k = 0;
+    while (i < n1 && j < n2) {
+        bool take_right = (right[j] ^ bias) < (left[i] ^ bias);
+        dest[k++] = take_right ? right[j] : left[i];
+        j += take_right;
+        i += !take_right;
+    }
+    memmove(dest + k, left + i, (n1 - i) * sizeof(int32_t));
+    memmove(dest + k + n1 - i, right + j, (n2 - j) * sizeof(int32_t));
+}
+
+/**
+ * Merge two sorted arrays of 64-bit keys without branches on the keys.
+ *
+ * @param dest The destination array. The right array may be the end of it.
+ * @param left The left array.
+ * @param n1 The number of elements in the left array.
+ * @param right The right array.
+ * @param n2 The number of elements in the right array.
+ * @param bias The value that the keys are xored with before they are compared.
+ */
+static void scalar_merge_64(int64_t *dest, const int64_t *left, size_t n1, const int64_t *right, size_t n2,
+                            int64_t bias) {
+    size_t i = 0;
+    size_t j = 0;
+    size_t k = 0;
+    while (i < n1 && j < n2) {
+        bool take_right = (right[j] ^ bias) < (left[i] ^ bias);
+        dest[k++] = take_right ? right[j] : left[i];
+        j += take_right;
+        i += !take_right;
+    }
+    memmove(dest + k, left + i, (n1 - i) * sizeof(int64_t));
+    memmove(dest + k + n1 - i, right + j, (n2 - j) * sizeof(int64_t));
+}
+
+#if SORT_NETWORK_X86
+
+/**
+ * Run an in-register step of the network over 32-bit keys with AVX2.
+ *
+ * @param v The register.
+ * @param x The partner of each lane i is the lane i ^ x.
+ * @return The register after the step.
+ */
+__attribute__((target("avx2")))
+static __m256i avx2_step_32(__m256i v, int x) {
+    __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i index = _mm256_xor_si256(lanes, _mm256_set1_epi32(x));
+    __m256i partner = _mm256_permutevar8x32_epi32(v, index);
+    __m256i take_max = _mm256_cmpgt_epi32(lanes, index);
+
+    return _mm256_blendv_epi8(_mm256_min_epi32(v, partner), _mm256_max_epi32(v, partner), take_max);
+}
+
+/**
+ * Run a flip step of the network between two registers of 32-bit keys with AVX2.
+ *
+ * @param a The register with the lower keys.
+ * @param b The register with the higher keys.
+ */
+__attribute__((target("avx2")))
+static void avx2_flip_32(__m256i *a, __m256i *b) {
+    __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    __m256i reversed = _mm256_permutevar8x32_epi32(*b, reverse);
+    __m256i low = _mm256_min_epi32(*a, reversed);
+    __m256i high = _mm256_max_epi32(*a, reversed);
+    *a = low;
+    *b = _mm256_permutevar8x32_epi32(high, reverse);
+}
+
+/**
+ * Run a half-cleaner step of the network between two registers of 32-bit keys with AVX2.
+ *
+ * @param a The register with the lower keys.
+ * @param b The register with the higher keys.
+ */
+__attribute__((target("avx2")))
+static void avx2_half_32(__m256i *a, __m256i *b) {
+    __m256i low = _mm256_min_epi32(*a, *b);
+    __m256i high = _mm256_max_epi32(*a, *b);
+    *a = low;
+    *b = high;
+}
+
+/**
+ * Sort 32-bit keys with the network with AVX2.
+ *
+ * @param keys The keys.
+ */
+__attribute__((target("avx2")))
+static void avx2_sort_32(int32_t *keys) {
+    __m256i v[2];
+    for (size_t r = 0; r < 2; r++) {
+        v[r] = _mm256_loadu_si256((const __m256i *) (keys + 8 * r));
+    }
+    SORT_NETWORK_RUN(v, 2, 8, avx2_step_32, avx2_flip_32, avx2_half_32)
+    for (size_t r = 0; r < 2; r++) {
+        _mm256_storeu_si256((__m256i *) (keys + 8 * r), v[r]);
+    }
+}
+
+/**
+ * Merge two sorted registers of 32-bit keys with AVX2. The second register is reversed, so that the lane-wise minimum
+ * and maximum split the keys into two bitonic halves, which are then sorted by half-cleaner steps.
+ *
+ * @param low The first register, set to the lower half of the keys.
+ * @param high The second register, set to the upper half of the keys.
+ */
+__attribute__((target("avx2")))
+static void avx2_merge_blocks_32(__m256i *low, __m256i *high) {
+    avx2_flip_32(low, high);
+    for (int d = 4; d > 0; d /= 2) {
+        *low = avx2_step_32(*low, d);
+        *high = avx2_step_32(*high, d);
+    }
+}
+
+/**
+ * Merge the rest of two sorted arrays and the keys that are left in the merge network. All three are sorted, and the
+ * merged keys are written without branches on which one is taken.
+ *
+ * @param dest The destination array. The right array may be the end of it.
+ * @param carry The keys that are left in the merge network.
+ * @param n0 The number of keys left in the merge network.
+ * @param left The rest of the left array.
+ * @param n1 The number of elements in the rest of the left array.
+ * @param right The rest of the right array.
+ * @param n2 The number of elements in the rest of the right array.
+ * @param bias The value that the keys are xored with before they are compared.
+ */
+static void merge_tail_32(int32_t *dest, const int32_t *carry, size_t n0, const int32_t *left, size_t n1,
+                          const int32_t *right, size_t n2, int32_t bias) {
+    // Merge the carry with the left array to a buffer first, which holds at most a register and a block of keys
+    int32_t buffer[2 * SORT_NETWORK_MAX];
+    if (n1 < SORT_NETWORK_MAX) {
+        scalar_merge_32(buffer, carry, n0, left, n1, bias);
+        scalar_merge_32(dest, buffer, n0 + n1, right, n2, bias);
+    } else {
+        scalar_merge_32(buffer, carry, n0, right, n2, bias);
+        scalar_merge_32(dest, left, n1, buffer, n0 + n2, bias);
+    }
+}
+
+/**
+ * Merge two sorted arrays of 32-bit keys with AVX2. The network holds a register of the largest keys seen so far.
+ * Each step loads a block from the array whose next key is smaller, merges it with the register, and writes out the
+ * lower half. Both arrays must hold at least one block.
+ *
+ * @param dest The destination array. The right array may be the end of it.
+ * @param left The left array.
+ * @param n1 The number of elements in the left array.
+ * @param right The right array.
+ * @param n2 The number of elements in the right array.
+ * @param bias The value that the keys are xored with before they are compared.
+ */
+__attribute__((target("avx2")))
+static void avx2_merge_32(int32_t *dest, const int32_t *left, size_t n1, const int32_t *right, size_t n2,
+                          int32_t bias) {
+    __m256i biases = _mm256_set1_epi32(bias);
+    __m256i low = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) left), biases);
+    __m256i high = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) right), biases);
+    size_t i = 8;
+    size_t j = 8;
+    size_t k = 0;
+    for (;;) {
+        avx2_merge_blocks_32(&low, &high);
+        _mm256_storeu_si256((__m256i *) (dest + k), _mm256_xor_si256(low, biases));
+        k += 8;
+        // The output never overtakes the right array, because the network holds a block that is not written yet
+        if (i + 8 <= n1 && j + 8 <= n2 && (left[i] ^ bias) < (right[j] ^ bias)) {
+            low = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (left + i)), biases);
+            i += 8;
+        } else if (i + 8 <= n1 && j + 8 <= n2) {
+            low = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (right + j)), biases);
+            j += 8;
+        } else {
+            break;
+        }
+    }
+    int32_t carry[8];
+    _mm256_storeu_si256((__m256i *) carry, _mm256_xor_si256(high, biases));
+    merge_tail_32(dest + k, carry, 8, left + i, n1 - i, right + j, n2 - j, bias);
+}
+
+/**
+ * Return the lane-wise minimum and maximum of two registers of 64-bit keys with AVX2.
+ *
+ * @param a The first register, set to the minimum.
+ * @param b The second register, set to the maximum.
+ */
+__attribute__((target("avx2")))
+static void avx2_min_max_64(__m256i *a, __m256i *b) {
+    __m256i greater = _mm256_cmpgt_epi64(*a, *b);
+    __m256i low = _mm256_blendv_epi8(*a, *b, greater);
+    __m256i high = _mm256_blendv_epi8(*b, *a, greater);
+    *a = low;
+    *b = high;
+}
+
+/**
+ * Run an in-register step of the network over 64-bit keys with AVX2. The lanes are permuted as pairs of 32-bit lanes.
+ *
+ * @param v The register.
+ * @param x The partner of each lane i is the lane i ^ x.
+ * @return The register after the step.
+ */
+__attribute__((target("avx2")))
+static __m256i avx2_step_64(__m256i v, int x) {
+    __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i index = _mm256_xor_si256(lanes, _mm256_set1_epi32(2 * x));
+    __m256i low = v;
+    __m256i high = _mm256_permutevar8x32_epi32(v, index);
+    avx2_min_max_64(&low, &high);
+
+    return _mm256_blendv_epi8(low, high, _mm256_cmpgt_epi32(lanes, index));
+}
+
+/**
+ * Run a flip step of the network between two registers of 64-bit keys with AVX2.
+ *
+ * @param a The register with the lower keys.
+ * @param b The register with the higher keys.
+ */
+__attribute__((target("avx2")))
+static void avx2_flip_64(__m256i *a, __m256i *b) {
+    __m256i reverse = _mm256_setr_epi32(6, 7, 4, 5, 2, 3, 0, 1);
+    __m256i reversed = _mm256_permutevar8x32_epi32(*b, reverse);
+    avx2_min_max_64(a, &reversed);
+    *b = _mm256_permutevar8x32_epi32(reversed, reverse);
+}
+
+/**
+ * Sort 64-bit keys with the network with AVX2.
+ *
+ * @param keys The keys.
+ */
+__attribute__((target("avx2")))
+static void avx2_sort_64(int64_t *keys) {
+    __m256i v[4];
+    for (size_t r = 0; r < 4; r++) {
+        v[r] = _mm256_loadu_si256((const __m256i *) (keys + 4 * r));
+    }
+    SORT_NETWORK_RUN(v, 4, 4, avx2_step_64, avx2_flip_64, avx2_min_max_64)
+    for (size_t r = 0; r < 4; r++) {
+        _mm256_storeu_si256((__m256i *) (keys + 4 * r), v[r]);
+    }
+}
+
+/**
+ * Merge two sorted registers of 64-bit keys with AVX2.
+ *
+ * @param low The first register, set to the lower half of the keys.
+ * @param high The second register, set to the upper half of the keys.
+ */
+__attribute__((target("avx2")))
+static void avx2_merge_blocks_64(__m256i *low, __m256i *high) {
+    avx2_flip_64(low, high);
+    for (int d = 2; d > 0; d /= 2) {
+        *low = avx2_step_64(*low, d);
+        *high = avx2_step_64(*high, d);
+    }
+}
+
+/**
+ * Merge the rest of two sorted arrays of 64-bit keys and the keys that are left in the merge network.
+ *
+ * @param dest The destination array. The right array may be the end of it.
+ * @param carry The keys that are left in the merge network.
+ * @param n0 The number of keys left in the merge network.
+ * @param left The rest of the left array.
+ * @param n1 The number of elements in the rest of the left array.
+ * @param right The rest of the right array.
+ * @param n2 The number of elements in the rest of the right array.
+ * @param bias The value that the keys are xored with before they are compared.
+ */
+static void merge_tail_64(int64_t *dest, const int64_t *carry, size_t n0, const int64_t *left, size_t n1,
+                          const int64_t *right, size_t n2, int64_t bias) {
+    int64_t buffer[2 * SORT_NETWORK_MAX];
+    if (n1 < SORT_NETWORK_MAX) {
+        scalar_merge_64(buffer, carry, n0, left, n1, bias);
+        scalar_merge_64(dest, buffer, n0 + n1, right, n2, bias);
+    } else {
+        scalar_merge_64(buffer, carry, n0, right, n2, bias);
+        scalar_merge_64(dest, left, n1, buffer, n0 + n2, bias);
+    }
+}
+
+/**
+ * Merge two sorted arrays of 64-bit keys with AVX2. Both arrays must hold at least one block.
+ *
+ * @param dest The destination array. The right array may be the end of it.
+ * @param left The left array.
+ * @param n1 The number of elements in the left array.
+ * @param right The right array.
+ * @param n2 The number of elements in the right array.
+ * @param bias The value that the keys are xored with before they are compared.
+ */
+__attribute__((target("avx2")))
+static void avx2_merge_64(int64_t *dest, const int64_t *left, size_t n1, const int64_t *right, size_t n2,
+                          int64_t bias) {
+    __m256i biases = _mm256_set1_epi64x(bias);
+    __m256i low = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) left), biases);
+    __m256i high = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) right), biases);
+    size_t i = 4;
+    size_t j = 4;
+    size_t k = 0;
+    for (;;) {
+        avx2_merge_blocks_64(&low, &high);
+        _mm256_storeu_si256((__m256i *) (dest + k), _mm256_xor_si256(low, biases));
+        k += 4;
+        if (i + 4 <= n1 && j + 4 <= n2 && (left[i] ^ bias) < (right[j] ^ bias)) {
+            low = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (left + i)), biases);
+            i += 4;
+        } else if (i + 4 <= n1 && j + 4 <= n2) {
+            low = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (right + j)), biases);
+            j += 4;
+        } else {
+            break;
+        }
+    }
+    int64_t carry[4];
+    _mm256_storeu_si256((__m256i *) carry, _mm256_xor_si256(high, biases));
+    merge_tail_64(dest + k, carry, 4, left + i, n1 - i, right + j, n2 - j, bias);
+}
+
+/**
+ * Permute the lanes of a register with SSE4.2, so that each lane i gets the lane i ^ x.
+ *
+ * @param v The register.
+ * @param x The value that the lane indexes are xored with, multiplied by the lane width in bytes.
+ * @param take_max Set to the mask of the lanes whose partner has a lower index.
+ * @return The permuted register.
+ */
+__attribute__((target("sse4.2")))
+static __m128i sse42_permute(__m128i v, int x, __m128i *take_max) {
+    __m128i bytes = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m128i index = _mm_xor_si128(bytes, _mm_set1_epi8((char) x));
+    *take_max = _mm_cmpgt_epi8(bytes, index);
+
+    return _mm_shuffle_epi8(v, index);
+}
+
+/**
+ * Run an in-register step of the network over 32-bit keys with SSE4.2.
+ *
+ * @param v The register.
+ * @param x The partner of each lane i is the lane i ^ x.
+ * @return The register after the step.
+ */
+__attribute__((target("sse4.2")))
+static __m128i sse42_step_32(__m128i v, int x) {
+    __m128i take_max;
+    __m128i partner = sse42_permute(v, 4 * x, &take_max);
+
+    return _mm_blendv_epi8(_mm_min_epi32(v, partner), _mm_max_epi32(v, partner), take_max);
+}
+
+/**
+ * Run a flip step of the network between two registers of 32-bit keys with SSE4.2.
+ *
+ * @param a The register with the lower keys.
+ * @param b The register with the higher keys.
+ */
+__attribute__((target("sse4.2")))
+static void sse42_flip_32(__m128i *a, __m128i *b) {
+    __m128i reversed = _mm_shuffle_epi32(*b, _MM_SHUFFLE(0, 1, 2, 3));
+    __m128i low = _mm_min_epi32(*a, reversed);
+    __m128i high = _mm_max_epi32(*a, reversed);
+    *a = low;
+    *b = _mm_shuffle_epi32(high, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+/**
+ * Run a half-cleaner step of the network between two registers of 32-bit keys with SSE4.2.
+ *
+ * @param a The register with the lower keys.
+ * @param b The register with the higher keys.
+ */
+__attribute__((target("sse4.2")))
+static void sse42_half_32(__m128i *a, __m128i *b) {
+    __m128i low = _mm_min_epi32(*a, *b);
+    __m128i high = _mm_max_epi32(*a, *b);
+    *a = low;
+    *b = high;
+}
+
+/**
+ * Sort 32-bit keys with the network with SSE4.2.
+ *
+ * @param keys The keys.
+ */
+__attribute__((target("sse4.2")))
+static void sse42_sort_32(int32_t *keys) {
+    __m128i v[4];
+    for (size_t r = 0; r < 4; r++) {
+        v[r] = _mm_loadu_si128((const __m128i *) (keys + 4 * r));
+    }
+    SORT_NETWORK_RUN(v, 4, 4, sse42_step_32, sse42_flip_32, sse42_half_32)
+    for (size_t r = 0; r < 4; r++) {
+        _mm_storeu_si128((__m128i *) (keys + 4 * r), v[r]);
+    }
+}
+
+/**
+ * Return the lane-wise minimum and maximum of two registers of 64-bit keys with SSE4.2.
+ *
+ * @param a The first register, set to the minimum.
+ * @param b The second register, set to the maximum.
+ */
+__attribute__((target("sse4.2")))
+static void sse42_min_max_64(__m128i *a, __m128i *b) {
+    __m128i greater = _mm_cmpgt_epi64(*a, *b);
+    __m128i low = _mm_blendv_epi8(*a, *b, greater);
+    __m128i high = _mm_blendv_epi8(*b, *a, greater);
+    *a = low;
+    *b = high;
+}
+
+/**
+ * Run an in-register step of the network over 64-bit keys with SSE4.2.
+ *
+ * @param v The register.
+ * @param x The partner of each lane i is the lane i ^ x.
+ * @return The register after the step.
+ */
+__attribute__((target("sse4.2")))
+static __m128i sse42_step_64(__m128i v, int x) {
+    __m128i take_max;
+    __m128i low = v;
+    __m128i high = sse42_permute(v, 8 * x, &take_max);
+    sse42_min_max_64(&low, &high);
+
+    return _mm_blendv_epi8(low, high, take_max);
+}
+
+/**
+ * Run a flip step of the network between two registers of 64-bit keys with SSE4.2.
+ *
+ * @param a The register with the lower keys.
+ * @param b The register with the higher keys.
+ */
+__attribute__((target("sse4.2")))
+static void sse42_flip_64(__m128i *a, __m128i *b) {
+    __m128i reversed = _mm_shuffle_epi32(*b, _MM_SHUFFLE(1, 0, 3, 2));
+    sse42_min_max_64(a, &reversed);
+    *b = _mm_shuffle_epi32(reversed, _MM_SHUFFLE(1, 0, 3, 2));
+}
+
+/**
+ * Sort 64-bit keys with the network with SSE4.2.
+ *
+ * @param keys The keys.
+ */
+__attribute__((target("sse4.2")))
+static void sse42_sort_64(int64_t *keys) {
+    __m128i v[8];
+    for (size_t r = 0; r < 8; r++) {
+        v[r] = _mm_loadu_si128((const __m128i *) (keys + 2 * r));
+    }
+    SORT_NETWORK_RUN(v, 8, 2, sse42_step_64, sse42_flip_64, sse42_min_max_64)
+    for (size_t r = 0; r < 8; r++) {
+        _mm_storeu_si128((__m128i *) (keys + 2 * r), v[r]);
+    }
+}
+
+#endif
+
+/**
+ * The instruction sets that the networks run on, from the slowest to the fastest.
+ */
+typedef enum {
+    ISA_UNKNOWN,
+    ISA_SCALAR,
+    ISA_SSE42,
+    ISA_AVX2
+} Isa;
+
+/**
+ * Return the instruction set that the networks run on, which is the best one that the processor supports. The
+ * environment variable SORT_NETWORK_ISA can select a slower one, "scalar" or "sse4.2", so that the fallback code can be
+ * tested on any processor. The instruction set is found on the first call.
+ *
+ * @return The instruction set.
+ */
+static Isa sort_network_isa(void) {
+    static atomic_int isa = ISA_UNKNOWN;
+    int current = atomic_load_explicit(&isa, memory_order_relaxed);
+    if (current == ISA_UNKNOWN) {
+        current = ISA_SCALAR;
+#if SORT_NETWORK_X86
+        if (__builtin_cpu_supports("avx2")) {
+            current = ISA_AVX2;
+        } else if (__builtin_cpu_supports("sse4.2")) {
+            current = ISA_SSE42;
+        }
+#endif
+        const char *name = getenv("SORT_NETWORK_ISA");
+        if (name && strcmp(name, "scalar") == 0) {
+            current = ISA_SCALAR;
+        } else if (name && strcmp(name, "sse4.2") == 0 && current > ISA_SSE42) {
+            current = ISA_SSE42;
+        }
+        atomic_store_explicit(&isa, current, memory_order_relaxed);
+    }
+
+    return (Isa) current;
+}
+
+/**
+ * Sort 32-bit keys with the network, on the instruction set that the networks run on.
+ *
+ * @param keys The keys.
+ */
+static void sort_32(int32_t *keys) {
+#if SORT_NETWORK_X86
+    Isa isa = sort_network_isa();
+    if (isa == ISA_AVX2) {
+        avx2_sort_32(keys);
+        return;
+    } else if (isa == ISA_SSE42) {
+        sse42_sort_32(keys);
+        return;
+    }
+#endif
+    scalar_sort_32(keys);
+}
+
+/**
+ * Sort 64-bit keys with the network, on the instruction set that the networks run on.
+ *
+ * @param keys The keys.
+ */
+static void sort_64(int64_t *keys) {
+#if SORT_NETWORK_X86
+    Isa isa = sort_network_isa();
+    if (isa == ISA_AVX2) {
+        avx2_sort_64(keys);
+        return;
+    } else if (isa == ISA_SSE42) {
+        sse42_sort_64(keys);
+        return;
+    }
+#endif
+    scalar_sort_64(keys);
+}
+
+void sort_network_i32(int32_t *base, size_t n) {
+    if (n < 2) {
+        return;
+    }
+    int32_t keys[SORT_NETWORK_MAX];
+    memcpy(keys, base, n * sizeof(int32_t));
+    for (size_t i = n; i < SORT_NETWORK_MAX; i++) {
+        keys[i] = INT32_MAX;
+    }
+    sort_32(keys);
+    memcpy(base, keys, n * sizeof(int32_t));
+}
+
+void sort_network_u32(uint32_t *base, size_t n) {
+    if (n < 2) {
+        return;
+    }
+    // Flip the sign bit, so that the keys sort as signed integers
+    int32_t keys[SORT_NETWORK_MAX];
+    for (size_t i = 0; i < SORT_NETWORK_MAX; i++) {
+        keys[i] = i < n ? (int32_t) (base[i] ^ (UINT32_C(1) << 31)) : INT32_MAX;
+    }
+    sort_32(keys);
+    for (size_t i = 0; i < n; i++) {
+        base[i] = (uint32_t) keys[i] ^ (UINT32_C(1) << 31);
+    }
+}
+
+void sort_network_i64(int64_t *base, size_t n) {
+    if (n < 2) {
+        return;
+    }
+    int64_t keys[SORT_NETWORK_MAX];
+    memcpy(keys, base, n * sizeof(int64_t));
+    for (size_t i = n; i < SORT_NETWORK_MAX; i++) {
+        keys[i] = INT64_MAX;
+    }
+    sort_64(keys);
+    memcpy(base, keys, n * sizeof(int64_t));
+}
+
+void sort_network_u64(uint64_t *base, size_t n) {
+    if (n < 2) {
+        return;
+    }
+    // Flip the sign bit, so that the keys sort as signed integers
+    int64_t keys[SORT_NETWORK_MAX];
+    for (size_t i = 0; i < SORT_NETWORK_MAX; i++) {
+        keys[i] = i < n ? (int64_t) (base[i] ^ (UINT64_C(1) << 63)) : INT64_MAX;
+    }
+    sort_64(keys);
+    for (size_t i = 0; i < n; i++) {
+        base[i] = (uint64_t) keys[i] ^ (UINT64_C(1) << 63);
+    }
+}
+
+/**
+ * Merge two sorted arrays of 32-bit keys, with the merge network if the networks run on AVX2.
+ *
+ * @param dest The destination array. The right array may be the end of it.
+ * @param left The left array.
+ * @param n1 The number of elements in the left array.
+ * @param right The right array.
+ * @param n2 The number of elements in the right array.
+ * @param bias The value that the keys are xored with before they are compared.
+ */
+static void merge_32(int32_t *dest, const int32_t *left, size_t n1, const int32_t *right, size_t n2, int32_t bias) {
+#if SORT_NETWORK_X86
+    if (n1 >= 8 && n2 >= 8 && sort_network_isa() == ISA_AVX2) {
+        avx2_merge_32(dest, left, n1, right, n2, bias);
+        return;
+    }
+#endif
+    scalar_merge_32(dest, left, n1, right, n2, bias);
+}
+
+/**
+ * Merge two sorted arrays of 64-bit keys, with the merge network if the networks run on AVX2.
+ *
+ * @param dest The destination array. The right array may be the end of it.
+ * @param left The left array.
+ * @param n1 The number of elements in the left array.
+ * @param right The right array.
+ * @param n2 The number of elements in the right array.
+ * @param bias The value that the keys are xored with before they are compared.
+ */
+static void merge_64(int64_t *dest, const int64_t *left, size_t n1, const int64_t *right, size_t n2, int64_t bias) {
+#if SORT_NETWORK_X86
+    if (n1 >= 4 && n2 >= 4 && sort_network_isa() == ISA_AVX2) {
+        avx2_merge_64(dest, left, n1, right, n2, bias);
+        return;
+    }
+#endif
+    scalar_merge_64(dest, left, n1, right, n2, bias);
+}
+
+void sort_network_merge_i32(int32_t *dest, const int32_t *left, size_t n1, const int32_t *right, size_t n2) {
+    merge_32(dest, left, n1, right, n2, 0);
+}
+
+void sort_network_merge_u32(uint32_t *dest, const uint32_t *left, size_t n1, const uint32_t *right, size_t n2) {
+    merge_32((int32_t *) dest, (const int32_t *) left, n1, (const int32_t *) right, n2, INT32_MIN);
+}
+
+void sort_network_merge_i64(int64_t *dest, const int64_t *left, size_t n1, const int64_t *right, size_t n2) {
+    merge_64(dest, left, n1, right, n2, 0);
+}
+
+void sort_network_merge_u64(uint64_t *dest, const uint64_t *left, size_t n1, const uint64_t *right, size_t n2) {
+    merge_64((int64_t *) dest, (const int64_t *) left, n1, (const int64_t *) right, n2, INT64_MIN);
+}
@@ -1,57 +1,428 @@
 #include "sorting.h"
+#include "sort_network.h"
 
-#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 // The cutoff-threshold to insertion sort
 #define CUTOFF 8
+// The size in bytes of the buffer on the stack that the in-place merge sort uses for short runs and rotations
+#define IN_PLACE_MERGE_BUFFER 4096
+// The array size above which the ninther is used to select the partitioning element
+#define NINTHER_THRESHOLD 128
+// The cutoff-threshold to insertion sort for pattern-defeating quick sort
+#define PDQ_INSERTION_THRESHOLD 24
+// The maximum number of elements moved by the partial insertion sort of pattern-defeating quick sort
+#define PDQ_PARTIAL_INSERTION_LIMIT 8
+// The number of elements examined at once by block partitioning
+#define PDQ_BLOCK_SIZE 64
+// The array size below which tim sort uses binary insertion sort, and below which runs are not merged
+#define TIM_MIN_MERGE 64
+// The initial number of consecutive wins of a run after which tim sort switches to galloping
+#define TIM_MIN_GALLOP 7
+// The maximum number of pending tim sort runs, which is enough for any array that fits in memory
+#define TIM_MAX_RUNS 96
+// The maximum number of Leonardo heaps of smooth sort, which is enough for any array that fits in memory
+#define SMOOTH_MAX_HEAPS 96
+// The array size below which parallel sorts continue sequentially
+#define PARALLEL_CUTOFF 8192
+// The number of bits of each radix sort digit
+#define RADIX_BITS 11
+// The number of distinct radix sort digits
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+// The mask that extracts a radix sort digit
+#define RADIX_MASK (RADIX_BUCKETS - 1)
+// The cutoff-threshold to insertion sort for radix sort
+#define RADIX_CUTOFF 64
+// The number of bits of each American flag sort digit
+#define AMERICAN_FLAG_BITS 8
+// The number of distinct American flag sort digits
+#define AMERICAN_FLAG_BUCKETS (1 << AMERICAN_FLAG_BITS)
+// The size of the buffer used to swap elements that have no specialized swap function
+#define SWAP_CHUNK_SIZE 64
+
+/**
+ * Prototype for a function that sets the value of an element to the value of another element.
+ *
+ * @param dest Pointer to the element to set.
+ * @param src Pointer to the element to copy.
+ * @param size The size in bytes of each element.
+ */
+typedef void (*SET_FUNC) (void *dest, const void *src, size_t size);
+
+/**
+ * Prototype for a function that swaps two elements.
+ *
+ * @param first Pointer to the first element.
+ * @param second Pointer to the second element.
+ * @param size The size in bytes of each element.
+ */
+typedef void (*SWAP_FUNC) (void *first, void *second, size_t size);
+
+#ifdef SORT_STATS
+/**
+ * The counters of the sort calls, which the threads of the parallel sorts update concurrently.
+ */
+typedef struct {
+    /** The number of comparisons. */
+    atomic_uint_least64_t comparisons;
+    /** The number of elements copied. */
+    atomic_uint_least64_t moves;
+    /** The number of elements swapped. */
+    atomic_uint_least64_t swaps;
+    /** The number of bytes allocated for auxiliary arrays. */
+    atomic_uint_least64_t aux_bytes;
+    /** The deepest recursion. */
+    atomic_uint_least64_t max_depth;
+} SortCounters;
+
+// The statistics that the sorts of the thread are counted to, or NULL
+static _Thread_local SortStats *current_stats;
+// The counters of the sorts of the thread
+static _Thread_local SortCounters current_counters;
+// The recursion depth of the sort running on the thread
+static _Thread_local size_t current_depth;
+#endif
+
+/**
+ * The context of a sort call. The functions that move elements are selected once per call, based on the element size.
+ */
+typedef struct {
+    /** The size in bytes of each element in the array. */
+    size_t size;
+    /** Pointer to a function that compares two elements. */
+    COMPARE_FUNC compare;
+    /** Pointer to a function that sets the value of an element. */
+    SET_FUNC set;
+    /** Pointer to a function that swaps two elements. */
+    SWAP_FUNC swap;
+#ifdef SORT_STATS
+    /** The counters of the sort call, or NULL if the statistics are not collected. */
+    SortCounters *counters;
+#endif
+} SortContext;
+
+/**
+ * Set the value of an element to the value of another element, for elements of 4, 8, 16 and 32 bytes. The copies have a
+ * constant size, so that the compiler turns them into a few loads and stores instead of calls to memcpy.
+ *
+ * @param dest Pointer to the element to set.
+ * @param src Pointer to the element to copy.
+ * @param size The size in bytes of each element, which is implied by the function.
+ */
+static void set_4(void *dest, const void *src, size_t size) {
+    (void) size;
+    memcpy(dest, src, 4);
+}
+
+static void set_8(void *dest, const void *src, size_t size) {
+    (void) size;
+    memcpy(dest, src, 8);
+}
+
+static void set_16(void *dest, const void *src, size_t size) {
+    (void) size;
+    memcpy(dest, src, 16);
+}
+
+static void set_32(void *dest, const void *src, size_t size) {
+    (void) size;
+    memcpy(dest, src, 32);
+}
+
+/**
+ * Set the value of an element to the value of another element, for elements of any size.
+ *
+ * @param dest Pointer to the element to set.
+ * @param src Pointer to the element to copy.
+ * @param size The size in bytes of each element.
+ */
+static void set_generic(void *dest, const void *src, size_t size) {
+    memcpy(dest, src, size);
+}
+
+/**
+ * Swap two elements through a temporary, for elements of 4, 8, 16 and 32 bytes. The copies have a constant size, so
+ * that the compiler keeps the temporary in registers instead of calling memcpy.
+ *
+ * @param first Pointer to the first element.
+ * @param second Pointer to the second element.
+ * @param size The size in bytes of each element, which is implied by the function.
+ */
+static void swap_4(void *first, void *second, size_t size) {
+    (void) size;
+    uint32_t temp;
+    memcpy(&temp, first, 4);
+    memcpy(first, second, 4);
+    memcpy(second, &temp, 4);
+}
+
+static void swap_8(void *first, void *second, size_t size) {
+    (void) size;
+    uint64_t temp;
+    memcpy(&temp, first, 8);
+    memcpy(first, second, 8);
+    memcpy(second, &temp, 8);
+}
+
+static void swap_16(void *first, void *second, size_t size) {
+    (void) size;
+    char temp[16];
+    memcpy(temp, first, 16);
+    memcpy(first, second, 16);
+    memcpy(second, temp, 16);
+}
+
+static void swap_32(void *first, void *second, size_t size) {
+    (void) size;
+    char temp[32];
+    memcpy(temp, first, 32);
+    memcpy(first, second, 32);
+    memcpy(second, temp, 32);
+}
+
+/**
+ * Swap two elements of any size, in chunks through a buffer of SWAP_CHUNK_SIZE bytes, so that wide elements are moved
+ * with a few memcpy calls.
+ *
+ * @param first Pointer to the first element.
+ * @param second Pointer to the second element.
+ * @param size The size in bytes of each element.
+ */
+static void swap_generic(void *first, void *second, size_t size) {
+    char temp[SWAP_CHUNK_SIZE];
+    char *a = first;
+    char *b = second;
+    while (size > 0) {
+        size_t chunk = size < SWAP_CHUNK_SIZE ? size : SWAP_CHUNK_SIZE;
+        memcpy(temp, a, chunk);
+        memcpy(a, b, chunk);
+        memcpy(b, temp, chunk);
+        a += chunk;
+        b += chunk;
+        size -= chunk;
+    }
+}
+
+/**
+ * Initialize the context of a sort call.
+ *
+ * @param ctx The sort context to initialize.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ */
+static void sort_context_init(SortContext *ctx, size_t size, COMPARE_FUNC compare) {
+    ctx->size = size;
+    ctx->compare = compare;
+#ifdef SORT_STATS
+    ctx->counters = current_stats ? &current_counters : NULL;
+#endif
+    switch (size) {
+        case 4:
+            ctx->set = set_4;
+            ctx->swap = swap_4;
+            break;
+        case 8:
+            ctx->set = set_8;
+            ctx->swap = swap_8;
+            break;
+        case 16:
+            ctx->set = set_16;
+            ctx->swap = swap_16;
+            break;
+        case 32:
+            ctx->set = set_32;
+            ctx->swap = swap_32;
+            break;
+        default:
+            ctx->set = set_generic;
+            ctx->swap = swap_generic;
+            break;
+    }
+}
+
+void sort_stats_begin(SortStats *stats) {
+    *stats = (SortStats) {0, 0, 0, 0, 0};
+#ifdef SORT_STATS
+    current_stats = stats;
+    atomic_store(&current_counters.comparisons, 0);
+    atomic_store(&current_counters.moves, 0);
+    atomic_store(&current_counters.swaps, 0);
+    atomic_store(&current_counters.aux_bytes, 0);
+    atomic_store(&current_counters.max_depth, 0);
+    current_depth = 0;
+#endif
+}
+
+void sort_stats_end(void) {
+#ifdef SORT_STATS
+    if (current_stats) {
+        current_stats->comparisons = atomic_load(&current_counters.comparisons);
+        current_stats->moves = atomic_load(&current_counters.moves);
+        current_stats->swaps = atomic_load(&current_counters.swaps);
+        current_stats->aux_bytes = atomic_load(&current_counters.aux_bytes);
+        current_stats->max_depth = atomic_load(&current_counters.max_depth);
+        current_stats = NULL;
+    }
+#endif
+}
+
+/**
+ * Count moves of elements that are not done by the set function, such as copies of whole ranges.
+ *
+ * @param ctx The sort context.
+ * @param n The number of elements moved.
+ */
+static void count_moves(const SortContext *ctx, size_t n) {
+#ifdef SORT_STATS
+    if (ctx->counters) {
+        atomic_fetch_add_explicit(&ctx->counters->moves, n, memory_order_relaxed);
+    }
+#else
+    (void) ctx;
+    (void) n;
+#endif
+}
+
+/**
+ * Count the allocation of an auxiliary array.
+ *
+ * @param ctx The sort context.
+ * @param bytes The size of the auxiliary array in bytes.
+ */
+static void count_aux(const SortContext *ctx, size_t bytes) {
+#ifdef SORT_STATS
+    if (ctx->counters) {
+        atomic_fetch_add_explicit(&ctx->counters->aux_bytes, bytes, memory_order_relaxed);
+    }
+#else
+    (void) ctx;
+    (void) bytes;
+#endif
+}
+
+/**
+ * Count the entry to a level of recursion. The levels are counted per thread.
+ *
+ * @param ctx The sort context.
+ */
+static void count_enter(const SortContext *ctx) {
+#ifdef SORT_STATS
+    if (ctx->counters) {
+        uint_least64_t depth = ++current_depth;
+        uint_least64_t max_depth = atomic_load_explicit(&ctx->counters->max_depth, memory_order_relaxed);
+        while (depth > max_depth && !atomic_compare_exchange_weak_explicit(&ctx->counters->max_depth, &max_depth,
+                                                                           depth, memory_order_relaxed,
+                                                                           memory_order_relaxed)) {
+        }
+    }
+#else
+    (void) ctx;
+#endif
+}
+
+/**
+ * Count the exit from levels of recursion.
+ *
+ * @param ctx The sort context.
+ * @param levels The number of levels.
+ */
+static void count_leave(const SortContext *ctx, size_t levels) {
+#ifdef SORT_STATS
+    if (ctx->counters) {
+        current_depth -= levels;
+    }
+#else
+    (void) ctx;
+    (void) levels;
+#endif
+}
+
+/**
+ * Compare two elements given their addresses.
+ *
+ * @param ctx The sort context.
+ * @param a Pointer to the first element.
+ * @param b Pointer to the second element.
+ * @return The result of the comparison function.
+ */
+static int compare_elements(const SortContext *ctx, const void *a, const void *b) {
+#ifdef SORT_STATS
+    if (ctx->counters) {
+        atomic_fetch_add_explicit(&ctx->counters->comparisons, 1, memory_order_relaxed);
+    }
+#endif
+    return ctx->compare(a, b);
+}
 
 /**
  * Swap two array elements.
  *
+ * @param ctx The sort context.
  * @param base A pointer to the first element of the array.
  * @param i Index of the first element to swap.
  * @param j Index of the second element to swap.
- * @param size The size in bytes of each element to be swapped.
  */
-static void swap(void *base, size_t i, size_t j, size_t size) {
-    size_t k = size;
-    while (k-- > 0) {
-        char temp = *((char *) base + i * size + k);
-        *((char *) base + i * size + k) = *((char *) base + j * size + k);
-        *((char *) base + j * size + k) = temp;
+static void swap(const SortContext *ctx, void *base, size_t i, size_t j) {
+    if (i != j) {
+#ifdef SORT_STATS
+        if (ctx->counters) {
+            atomic_fetch_add_explicit(&ctx->counters->swaps, 1, memory_order_relaxed);
+        }
+#endif
+        ctx->swap((char *) base + i * ctx->size, (char *) base + j * ctx->size, ctx->size);
     }
 }
 
 /**
- * Set the value of the first array element to the value of the second element.
+ * Swap two elements given their addresses.
  *
+ * @param ctx The sort context.
  * @param a Pointer to the first element.
  * @param b Pointer to the second element.
- * @param size The size in bytes of each element to be swapped.
  */
-static void set(void *a, void *b, size_t size) {
-    size_t k = size;
-    while (k-- > 0) {
-        *((char *) a + k) = *((char *) b + k);
+static void swap_elements(const SortContext *ctx, void *a, void *b) {
+    if (a != b) {
+#ifdef SORT_STATS
+        if (ctx->counters) {
+            atomic_fetch_add_explicit(&ctx->counters->swaps, 1, memory_order_relaxed);
+        }
+#endif
+        ctx->swap(a, b, ctx->size);
     }
 }
 
+/**
+ * Set the value of the first array element to the value of the second element.
+ *
+ * @param ctx The sort context.
+ * @param a Pointer to the first element.
+ * @param b Pointer to the second element.
+ */
+static void set(const SortContext *ctx, void *a, const void *b) {
+    count_moves(ctx, 1);
+    ctx->set(a, b, ctx->size);
+}
+
 /**
  * Check if the provided array is sorted.
  *
+ * @param ctx The sort context.
  * @param base A pointer to the first element of the array to be sorted.
  * @param n The number of elements in the array pointed by base.
- * @param size The size in bytes of each element in the array.
- * @param compare Pointer to a function that compares two elements.
  */
-static bool sorted(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+static bool sorted(const SortContext *ctx, void *base, size_t n) {
+    size_t size = ctx->size;
     if (n < 2) {
         return true;
     }
     for (size_t i = 0; i < n - 1; i++) {
-        if (compare((char *) base + i * size, (char *) base + (i + 1) * size) > 0) {
+        if (ctx->compare((char *) base + i * size, (char *) base + (i + 1) * size) > 0) {
             return false;
         }
     }
@@ -59,18 +430,29 @@ static bool sorted(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
     return true;
 }
 
+/**
+ * Check if two array elements are in order.
+ *
+ * @param ctx The sort context.
+ * @param base A pointer to the first element of the array.
+ * @param i The index of the first element.
+ * @param j The index of the second element.
+ */
+static bool ordered(const SortContext *ctx, const void *base, size_t i, size_t j) {
+    return ctx->compare((const char *) base + i * ctx->size, (const char *) base + j * ctx->size) <= 0;
+}
+
 /**
  * Check if the provided array is h-sorted.
  *
+ * @param ctx The sort context.
  * @param base A pointer to the first element of the array to be sorted.
  * @param n The number of elements in the array pointed by base.
- * @param size The size in bytes of each element in the array.
- * @param compare Pointer to a function that compares two elements.
  */
-static bool hsorted(void *base, size_t n, size_t h, size_t size,
-                    COMPARE_FUNC compare) {
+static bool hsorted(const SortContext *ctx, void *base, size_t n, size_t h) {
+    size_t size = ctx->size;
     for (size_t i = h; i < n - 1; i++) {
-        if (compare((char *) base + i * size, (char *) base + (i - h) * size) < 0) {
+        if (ctx->compare((char *) base + i * size, (char *) base + (i - h) * size) < 0) {
             return false;
         }
     }
@@ -79,29 +461,65 @@ static bool hsorted(void *base, size_t n, size_t h, size_t size,
 }
 
 /**
- * Sort an array using insertion sort.
+ * Check if the provided array is partitioned around an element: no element before it is greater, and no element after
+ * it is less.
+ *
+ * @param ctx The sort context.
+ * @param base A pointer to the first element of the array.
+ * @param n The number of elements in the array pointed by base.
+ * @param k The index of the element.
+ */
+static bool partitioned(const SortContext *ctx, void *base, size_t n, size_t k) {
+    size_t size = ctx->size;
+    for (size_t i = 0; i < n; i++) {
+        int cmp = ctx->compare((char *) base + i * size, (char *) base + k * size);
+        if ((i < k && cmp > 0) || (i > k && cmp < 0)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Implement insertion sort on the array.
  *
+ * @param ctx The sort context.
  * @param base A pointer to the first element of the array to be sorted.
  * @param n The number of elements in the array pointed by base.
- * @param size The size in bytes of each element in the array.
- * @param compare Pointer to a function that compares two elements.
  */
-void insertion_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+static void insertion_sort_impl(const SortContext *ctx, void *base, size_t n) {
+    size_t size = ctx->size;
     char key[size];
     for (size_t i = 1; i < n; i++) {
-        set(key, (char *) base + i * size, size);
+        set(ctx, key, (char *) base + i * size);
         size_t j = i - 1;
-        while (j <= i - 1 && compare((char *) base + j * size, key) > 0) {
-            set((char *) base + (j + 1) * size, (char *) base + j * size, size);
+        while (j <= i - 1 && compare_elements(ctx, (char *) base + j * size, key) > 0) {
+            set(ctx, (char *) base + (j + 1) * size, (char *) base + j * size);
             j--;
         }
-        set((char *) base + (j + 1) * size, key, size);
+        set(ctx, (char *) base + (j + 1) * size, key);
 
         // Invariant: The elements up until i must be sorted.
-        assert(sorted(base, i, size, compare));
+        CHECK(j + 1 == 0 || ordered(ctx, base, j, j + 1));
+        CHECK_FULL(sorted(ctx, base, i));
     }
     // Assertion: The array must be sorted.
-    assert(sorted(base, n, size, compare));
+    CHECK_SAMPLED(sorted(ctx, base, n));
+}
+
+/**
+ * Sort an array using insertion sort.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ */
+void insertion_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    SortContext ctx;
+    sort_context_init(&ctx, size, compare);
+    insertion_sort_impl(&ctx, base, n);
 }
 
 /**
@@ -113,24 +531,27 @@ void insertion_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
  * @param compare Pointer to a function that compares two elements.
  */
 void bubble_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    SortContext ctx;
+    sort_context_init(&ctx, size, compare);
     for (size_t i = 1; i < n; i++) {
         bool swapped = false;
         for (size_t j = n - 1; j >= i; j--) {
-            if (compare((char *) base + (j - 1) * size,
-                        (char *) base + j * size) > 0) {
-                swap(base, (j - 1), j, size);
+            if (compare_elements(&ctx, (char *) base + (j - 1) * size,
+                                 (char *) base + j * size) > 0) {
+                swap(&ctx, base, (j - 1), j);
                 swapped = true;
             }
         }
 
         // Invariant: The elements up until i must be sorted.
-        assert(sorted(base, i, size, compare));
+        CHECK(ordered(&ctx, base, i - 1, i));
+        CHECK_FULL(sorted(&ctx, base, i));
         if (!swapped) {
             break;
         }
     }
     // Assertion: The array must be sorted.
-    assert(sorted(base, n, size, compare));
+    CHECK_SAMPLED(sorted(&ctx, base, n));
 }
 
 /**
@@ -142,20 +563,23 @@ void bubble_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
  * @param compare Pointer to a function that compares two elements.
  */
 void selection_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    SortContext ctx;
+    sort_context_init(&ctx, size, compare);
     for (size_t i = 0; i < n; i++) {
         size_t min = i;
         for (size_t j = i + 1; j < n; j++) {
-            if (compare((char *) base + j * size, (char *) base + min * size) < 0) {
+            if (compare_elements(&ctx, (char *) base + j * size, (char *) base + min * size) < 0) {
                 min = j;
             }
         }
-        swap(base, i, min, size);
+        swap(&ctx, base, i, min);
 
         // Invariant: The elements up until i + 1 must be sorted.
-        assert(sorted(base, i + 1, size, compare));
+        CHECK(i == 0 || ordered(&ctx, base, i - 1, i));
+        CHECK_FULL(sorted(&ctx, base, i + 1));
     }
     // Assertion: The array must be sorted.
-    assert(sorted(base, n, size, compare));
+    CHECK_SAMPLED(sorted(&ctx, base, n));
 }
 
 /**
@@ -167,6 +591,8 @@ void selection_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
  * @param compare Pointer to a function that compares two elements.
  */
 void shell_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    SortContext ctx;
+    sort_context_init(&ctx, size, compare);
     size_t h = 1;
     while (h < n / 3) {
         h = 3 * h + 1;
@@ -174,185 +600,3333 @@ void shell_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
     while (h >= 1) {
         for (size_t i = h; i < n; i++) {
             for (size_t j = i;
-                 j >= h && compare((char *) base + j * size, (char *) base + (j - h) * size) < 0;
+                 j >= h && compare_elements(&ctx, (char *) base + j * size, (char *) base + (j - h) * size) < 0;
                  j -= h) {
-                swap(base, j, (j - h), size);
+                swap(&ctx, base, j, (j - h));
             }
         }
         // Assertion: The array must be h-sorted.
-        assert(hsorted(base, n, h, size, compare));
+        CHECK_FULL(hsorted(&ctx, base, n, h));
         h = h / 3;
     }
     // Assertion: The array must be sorted.
-    assert(sorted(base, n, size, compare));
+    CHECK_SAMPLED(sorted(&ctx, base, n));
+}
+
+/**
+ * Merge two sorted runs to the destination array. When two elements are equal, the element from the left run is
+ * placed first, so the merge is stable.
+ *
+ * @param ctx The sort context.
+ * @param dest The destination array. It must not overlap with the runs.
+ * @param left The left run.
+ * @param n1 The number of elements in the left run.
+ * @param right The right run.
+ * @param n2 The number of elements in the right run.
+ */
+static void merge_runs(const SortContext *ctx, void *dest, const void *left, size_t n1, const void *right, size_t n2) {
+    size_t size = ctx->size;
+    const char *i = left;
+    const char *i_end = i + n1 * size;
+    const char *j = right;
+    const char *j_end = j + n2 * size;
+    char *k = dest;
+    while (i < i_end && j < j_end) {
+        if (compare_elements(ctx, j, i) < 0) {
+            // The element from the right part is smaller
+            set(ctx, k, j);
+            j += size;
+        } else {
+            // The element from the left part is smaller
+            set(ctx, k, i);
+            i += size;
+        }
+        k += size;
+    }
+    // One of the runs is exhausted, copy the rest of the other one.
+    count_moves(ctx, (size_t) (i_end - i + j_end - j) / size);
+    memcpy(k, i, (size_t) (i_end - i));
+    memcpy(k + (i_end - i), j, (size_t) (j_end - j));
 }
 
 /**
  * Merge the two sorted sub-arrays from low to mid and from mid + 1 to high,
  * to one sorted array.
  *
+ * @param ctx The sort context.
  * @param base The array to be sorted.
  * @param aux The auxiliary array.
  * @param low The index of the first array element to merge.
  * @param mid The index of the element that splits the sorted halves.
  * @param high The index of the last array element to merge.
- * @param size The size in bytes of each element in the array.
- * @param compare Pointer to a function that compares two elements.
  */
-static void merge(void *base, void *aux, size_t low, size_t mid, size_t high, size_t size, COMPARE_FUNC compare) {
+static void merge(const SortContext *ctx, void *base, void *aux, size_t low, size_t mid, size_t high) {
+    size_t size = ctx->size;
     // Assertion: The array from low to mid must be sorted
-    assert(sorted((char *) base + low * size, mid - low, size, compare));
+    CHECK_FULL(sorted(ctx, (char *) base + low * size, mid - low));
     // Assertion: The array from mid + 1 to high must be sorted
-    assert(sorted((char *) base + (mid + 1) * size, high - mid, size, compare));
+    CHECK_FULL(sorted(ctx, (char *) base + (mid + 1) * size, high - mid));
     // Copy to the auxiliary array
+    count_moves(ctx, high - low + 1);
     memcpy((char *) aux + low * size, (char *) base + low * size, (high - low + 1) * size);
     // Merge the two halves
-    size_t i = low;
-    size_t j = mid + 1;
-    for (size_t k = low; k <= high; k++) {
-        if (i > mid) {
-            // The left half is exhausted, take from the right half.
-            set((char *) base + size * k, (char *) aux + size * j++, size);
-        } else if (j > high) {
-            // The right half is exhausted, take from the left half.
-            set((char *) base + size * k, (char *) aux + size * i++, size);
-        } else if (compare((char *) aux + j * size, (char *) aux + i * size) < 0) {
-            // The element from the right part is smaller
-            set((char *) base + size * k, (char *) aux + size * j++, size);
-        } else {
-            // The element from the left part is smaller
-            set((char *) base + size * k, (char *) aux + size * i++, size);
-        }
-    }
+    merge_runs(ctx, (char *) base + low * size, (char *) aux + low * size, mid - low + 1,
+               (char *) aux + (mid + 1) * size, high - mid);
 }
 
 /**
  * Implement the merge sort on the array, using the auxiliary array for storage.
  *
+ * @param ctx The sort context.
  * @param base The array to be sorted.
  * @param aux The auxiliary array.
  * @param low The index of the first array element to sort.
  * @param high The index of the last array element to sort.
- * @param size The size in bytes of each element in the array.
- * @param compare Pointer to a function that compares two elements.
  */
-static void merge_sort_impl(void *base, void *aux, size_t low, size_t high, size_t size, COMPARE_FUNC compare) {
+static void merge_sort_impl(const SortContext *ctx, void *base, void *aux, size_t low, size_t high) {
+    size_t size = ctx->size;
     // For small arrays, cutoff to insertion sort
     if (high < low + CUTOFF) {
-        insertion_sort((char *) base + low * size, high - low + 1, size, compare);
+        insertion_sort_impl(ctx, (char *) base + low * size, high - low + 1);
         return;
     }
     // Find the mid point
     size_t mid = low + (high - low) / 2;
     // Sort the two halves
-    merge_sort_impl(base, aux, low, mid, size, compare);
-    merge_sort_impl(base, aux, mid + 1, high, size, compare);
+    count_enter(ctx);
+    merge_sort_impl(ctx, base, aux, low, mid);
+    merge_sort_impl(ctx, base, aux, mid + 1, high);
+    count_leave(ctx, 1);
     // Check if the two sub-arrays are already sorted, so that we don't need to
     // merge
-    if (compare((char *) base + (mid + 1) * size, (char *) base + mid * size) > 0) {
+    if (compare_elements(ctx, (char *) base + (mid + 1) * size, (char *) base + mid * size) > 0) {
         return;
     }
     // Merge the sorted halves
-    merge(base, aux, low, mid, high, size, compare);
+    merge(ctx, base, aux, low, mid, high);
 }
 
 /**
- * Sort an array using merge sort.
+ * Return the index of the first element of a sorted array that is greater than a key, or also equal to it.
  *
- * @param base A pointer to the first element of the array to be sorted.
+ * @param ctx The sort context.
+ * @param base A pointer to the first element of the sorted array.
  * @param n The number of elements in the array pointed by base.
- * @param size The size in bytes of each element in the array.
- * @param compare Pointer to a function that compares two elements.
+ * @param key Pointer to the key.
+ * @param upper true to find the first element that is greater than the key, false to find the first element that is
+ * greater than or equal to it.
+ * @return The index of the element, or n if there is no such element.
  */
-void merge_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
-    // Allocate the auxiliary array.
-    void *aux = malloc(n * size);
-    // Sort the array
-    merge_sort_impl(base, aux, 0, n - 1, size, compare);
-    // Deallocate the auxiliary array.
-    free(aux);
-    // Assertion: The array must be sorted.
-    assert(sorted(base, n, size, compare));
+static size_t in_place_merge_bound(const SortContext *ctx, const char *base, size_t n, const void *key, bool upper) {
+    size_t low = 0;
+    while (n > 0) {
+        size_t half = n / 2;
+        int cmp = compare_elements(ctx, base + (low + half) * ctx->size, key);
+        if (cmp < 0 || (upper && cmp == 0)) {
+            low += half + 1;
+            n -= half + 1;
+        } else {
+            n = half;
+        }
+    }
+
+    return low;
 }
 
 /**
- * Partition the array to two parts: The left one (from low to p - 1) is less than or equal to the partitioning element
- * (p) and the right one (from p + 1 to high) is greater than or equal to the partitioning element.
+ * Rotate an array, so that its first n1 elements are moved after the next n2 elements. The buffer is used if the
+ * smaller part fits in it, otherwise the array is rotated with three reversals.
  *
- * @param base A pointer to the first element of the array to be sorted.
- * @param low The index of the first array element to sort.
- * @param high The index of the last array element to sort.
- * @param size The size in bytes of each element in the array.
- * @param compare Pointer to a function that compares two elements.
- * @return The index of the partitioning element.
+ * @param ctx The sort context.
+ * @param base A pointer to the first element of the array.
+ * @param n1 The number of elements of the first part.
+ * @param n2 The number of elements of the second part.
+ * @param buffer The buffer, of IN_PLACE_MERGE_BUFFER bytes.
  */
-static size_t quick_sort_partition(void *base, size_t low, size_t high, size_t size, COMPARE_FUNC compare) {
-    size_t i = low;
-    size_t j = high + 1;
+static void in_place_merge_rotate(const SortContext *ctx, char *base, size_t n1, size_t n2, char *buffer) {
+    size_t size = ctx->size;
+    if (n1 == 0 || n2 == 0) {
+        return;
+    }
+    if (n1 <= n2 && n1 * size <= IN_PLACE_MERGE_BUFFER) {
+        count_moves(ctx, n1 + n2 + n1);
+        memcpy(buffer, base, n1 * size);
+        memmove(base, base + n1 * size, n2 * size);
+        memcpy(base + n2 * size, buffer, n1 * size);
+    } else if (n2 < n1 && n2 * size <= IN_PLACE_MERGE_BUFFER) {
+        count_moves(ctx, n2 + n1 + n2);
+        memcpy(buffer, base + n1 * size, n2 * size);
+        memmove(base + n2 * size, base, n1 * size);
+        memcpy(base, buffer, n2 * size);
+    } else {
+        for (size_t i = 0, j = n1 - 1; i < j; i++, j--) {
+            swap(ctx, base, i, j);
+        }
+        for (size_t i = n1, j = n1 + n2 - 1; i < j; i++, j--) {
+            swap(ctx, base, i, j);
+        }
+        for (size_t i = 0, j = n1 + n2 - 1; i < j; i++, j--) {
+            swap(ctx, base, i, j);
+        }
+    }
+}
 
-    while (true) {
-        // Find the element on left to swap
-        while (compare((char *) base + (++i) * size, (char *) base + low * size) < 0) {
-            if (i == high) {
-                break;
-            }
+/**
+ * Merge two adjacent sorted runs in place. If the left run fits in the buffer, it is copied there and merged with the
+ * right run. Otherwise the larger run is split in half, the matching split point of the other run is found by binary
+ * search, the middle parts are swapped by a rotation, and the two pairs of runs are merged recursively.
+ *
+ * @param ctx The sort context.
+ * @param base A pointer to the first element of the left run.
+ * @param n1 The number of elements of the left run.
+ * @param n2 The number of elements of the right run, which starts right after the left run.
+ * @param buffer The buffer, of IN_PLACE_MERGE_BUFFER bytes.
+ */
+static void in_place_merge(const SortContext *ctx, char *base, size_t n1, size_t n2, char *buffer) {
+    size_t size = ctx->size;
+    size_t levels = 0;
+    while (n1 > 0 && n2 > 0) {
+        if (n1 * size <= IN_PLACE_MERGE_BUFFER) {
+            count_moves(ctx, n1);
+            memcpy(buffer, base, n1 * size);
+            merge_runs(ctx, base, buffer, n1, base + n1 * size, n2);
+            break;
         }
-        // Find the element on right to swap
-        while (compare((char *) base + low * size, (char *) base + (--j) * size) < 0) {
-            if (j == low) {
-                break;
-            }
+        if (n1 == 1) {
+            // Rotate the element of the left run after the smaller elements of the right run
+            in_place_merge_rotate(ctx, base, 1, in_place_merge_bound(ctx, base + size, n2, base, false), buffer);
+            break;
         }
-        // Break if indexes crossed
-        if (i >= j) {
+        if (n2 == 1) {
+            // Rotate the element of the right run before the bigger elements of the left run
+            size_t cut1 = in_place_merge_bound(ctx, base, n1, base + n1 * size, true);
+            in_place_merge_rotate(ctx, base + cut1 * size, n1 - cut1, 1, buffer);
             break;
         }
-        swap(base, i, j, size);
+        // Split the runs, so that the elements of the left parts are placed before the elements of the right parts.
+        // Both runs have at least two elements, so both pairs of runs are smaller than the runs.
+        size_t cut1;
+        size_t cut2;
+        if (n1 > n2) {
+            cut1 = n1 / 2;
+            cut2 = in_place_merge_bound(ctx, base + n1 * size, n2, base + cut1 * size, false);
+        } else {
+            cut2 = n2 / 2;
+            cut1 = in_place_merge_bound(ctx, base, n1, base + (n1 + cut2) * size, true);
+        }
+        in_place_merge_rotate(ctx, base + cut1 * size, n1 - cut1, cut2, buffer);
+        // Merge the smaller pair recursively, and loop on the larger one
+        char *middle = base + (cut1 + cut2) * size;
+        count_enter(ctx);
+        levels++;
+        if (cut1 + cut2 < n1 + n2 - cut1 - cut2) {
+            in_place_merge(ctx, base, cut1, cut2, buffer);
+            base = middle;
+            n1 -= cut1;
+            n2 -= cut2;
+        } else {
+            in_place_merge(ctx, middle, n1 - cut1, n2 - cut2, buffer);
+            n1 = cut1;
+            n2 = cut2;
+        }
     }
+    count_leave(ctx, levels);
+}
 
-    // Put the partitioning element on its final position
-    swap(base, low, j, size);
-
-    return j;
+/**
+ * Implement the in-place merge sort on the array.
+ *
+ * @param ctx The sort context.
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param buffer The buffer, of IN_PLACE_MERGE_BUFFER bytes.
+ */
+static void in_place_merge_sort_impl(const SortContext *ctx, char *base, size_t n, char *buffer) {
+    // For small arrays, cutoff to insertion sort
+    if (n <= CUTOFF) {
+        insertion_sort_impl(ctx, base, n);
+        return;
+    }
+    // Sort the two halves
+    size_t mid = n / 2;
+    count_enter(ctx);
+    in_place_merge_sort_impl(ctx, base, mid, buffer);
+    in_place_merge_sort_impl(ctx, base + mid * ctx->size, n - mid, buffer);
+    count_leave(ctx, 1);
+    // Merge them, unless they are already in order
+    if (compare_elements(ctx, base + mid * ctx->size, base + (mid - 1) * ctx->size) < 0) {
+        in_place_merge(ctx, base, mid, n - mid, buffer);
+    }
 }
 
 /**
- * Implement quick sort on the array,
+ * Sort an array using merge sort.
  *
  * @param base A pointer to the first element of the array to be sorted.
- * @param low The index of the first array element to sort.
- * @param high The index of the last array element to sort.
+ * @param n The number of elements in the array pointed by base.
  * @param size The size in bytes of each element in the array.
  * @param compare Pointer to a function that compares two elements.
  */
-static void quick_sort_impl(void *base, size_t low, size_t high, size_t size, COMPARE_FUNC compare) {
-    // For small arrays, cutoff to insertion sort
-    if (high < low + CUTOFF) {
-        insertion_sort((char *) base + low * size, high - low + 1, size, compare);
+void merge_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    if (n < 2) {
         return;
     }
-    size_t p = quick_sort_partition(base, low, high, size, compare);
-    if (low + 1 < p) {
-        quick_sort_impl((char *) base, low, p - 1, size, compare);
-    }
-    if (p + 1 < high) {
-        quick_sort_impl((char *) base, p + 1, high, size, compare);
+    // Allocate the auxiliary array, or sort in place if it cannot be allocated
+    void *aux = malloc(n * size);
+    if (!aux) {
+        in_place_merge_sort(base, n, size, compare);
+        return;
     }
-    // Assertion: The array from low to high must be sorted
-    assert(sorted((char *) base + low * size, high - low, size, compare));
+    merge_sort_scratch(base, n, size, compare, aux);
+    // Deallocate the auxiliary array.
+    free(aux);
 }
 
 /**
- * Sort an array using quick sort.
+ * Sort an array using merge sort, with an auxiliary array that is provided by the caller.
  *
  * @param base A pointer to the first element of the array to be sorted.
  * @param n The number of elements in the array pointed by base.
  * @param size The size in bytes of each element in the array.
  * @param compare Pointer to a function that compares two elements.
+ * @param scratch The auxiliary array, of at least n elements.
  */
-void quick_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
-    quick_sort_impl(base, 0, n - 1, size, compare);
+void merge_sort_scratch(void *base, size_t n, size_t size, COMPARE_FUNC compare, void *scratch) {
+    SortContext ctx;
+    sort_context_init(&ctx, size, compare);
+    if (n < 2) {
+        return;
+    }
+    count_aux(&ctx, n * size);
+    // Sort the array
+    merge_sort_impl(&ctx, base, scratch, 0, n - 1);
     // Assertion: The array must be sorted.
-    assert(sorted(base, n, size, compare));
+    CHECK_SAMPLED(sorted(&ctx, base, n));
 }
 
+/**
+ * Sort an array using merge sort, without an auxiliary array.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ */
+void in_place_merge_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    SortContext ctx;
+    sort_context_init(&ctx, size, compare);
+    char buffer[IN_PLACE_MERGE_BUFFER];
+    in_place_merge_sort_impl(&ctx, base, n, buffer);
+    // Assertion: The array must be sorted.
+    CHECK_SAMPLED(sorted(&ctx, base, n));
+}
+
+/**
+ * Return the number of threads to use for a parallel sort. The number of threads is at most the number of online
+ * processors, and small arrays use fewer threads, so that each thread sorts at least PARALLEL_CUTOFF elements.
+ *
+ * @param nthreads The number of threads requested, or zero to use one thread per online processor.
+ * @param n The number of elements to sort.
+ * @return The number of threads to use, which is at least one.
+ */
+static size_t sort_threads(size_t nthreads, size_t n) {
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_threads = processors > 0 ? (size_t) processors : 1;
+    if (nthreads == 0 || nthreads > max_threads) {
+        nthreads = max_threads;
+    }
+    if (nthreads > n / PARALLEL_CUTOFF) {
+        nthreads = n / PARALLEL_CUTOFF > 0 ? n / PARALLEL_CUTOFF : 1;
+    }
+
+    return nthreads;
+}
+
+/**
+ * Run a function on each element of an array of tasks, with one thread per task. The first task runs on the calling
+ * thread. If a thread cannot be created, its task also runs on the calling thread, and if the thread handles cannot be
+ * allocated, all the tasks run on the calling thread.
+ *
+ * @param func The function to run.
+ * @param tasks A pointer to the first task.
+ * @param n The number of tasks.
+ * @param task_size The size in bytes of each task.
+ */
+static void run_parallel(void *(*func) (void *), void *tasks, size_t n, size_t task_size) {
+    pthread_t *threads = malloc(n * sizeof(pthread_t));
+    bool *spawned = malloc(n * sizeof(bool));
+    if (!threads || !spawned) {
+        free(threads);
+        free(spawned);
+        for (size_t i = 0; i < n; i++) {
+            func((char *) tasks + i * task_size);
+        }
+        return;
+    }
+    for (size_t i = 1; i < n; i++) {
+        spawned[i] = pthread_create(&threads[i], NULL, func, (char *) tasks + i * task_size) == 0;
+        if (!spawned[i]) {
+            func((char *) tasks + i * task_size);
+        }
+    }
+    func(tasks);
+    for (size_t i = 1; i < n; i++) {
+        if (spawned[i]) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+    free(threads);
+    free(spawned);
+}
+
+/**
+ * Find how many elements of the left run are among the first k elements of the stable merge of two sorted runs.
+ *
+ * @param ctx The sort context.
+ * @param left The left run.
+ * @param n1 The number of elements in the left run.
+ * @param right The right run.
+ * @param n2 The number of elements in the right run.
+ * @param k The number of merged elements.
+ * @return The number of elements of the left run. The rest k minus that elements come from the right run.
+ */
+static size_t co_rank(const SortContext *ctx, const void *left, size_t n1, const void *right, size_t n2, size_t k) {
+    size_t size = ctx->size;
+    size_t low = k > n2 ? k - n2 : 0;
+    size_t high = k < n1 ? k : n1;
+    while (low < high) {
+        size_t i = low + (high - low) / 2;
+        size_t j = k - i;
+        if (j > 0 &&
+            compare_elements(ctx, (const char *) left + i * size, (const char *) right + (j - 1) * size) <= 0) {
+            // The element of the left run is merged before the last element taken from the right run
+            low = i + 1;
+        } else {
+            high = i;
+        }
+    }
+
+    return low;
+}
+
+/**
+ * A part of a parallel merge. Each part copies or merges a contiguous range of the output.
+ */
+typedef struct {
+    /** The sort context. */
+    const SortContext *ctx;
+    /** The array to be sorted. */
+    void *base;
+    /** The auxiliary array. */
+    void *aux;
+    /** The index of the first array element to merge. */
+    size_t low;
+    /** The index of the element that splits the sorted halves. */
+    size_t mid;
+    /** The index of the last array element to merge. */
+    size_t high;
+    /** The index of the first output element of the part, relative to low. */
+    size_t begin;
+    /** The index past the last output element of the part, relative to low. */
+    size_t end;
+} MergePart;
+
+/**
+ * Copy the range of a parallel merge part to the auxiliary array.
+ *
+ * @param arg Pointer to the merge part.
+ * @return NULL.
+ */
+static void *merge_part_copy(void *arg) {
+    MergePart *part = arg;
+    size_t size = part->ctx->size;
+    size_t offset = (part->low + part->begin) * size;
+    count_moves(part->ctx, part->end - part->begin);
+    memcpy((char *) part->aux + offset, (char *) part->base + offset, (part->end - part->begin) * size);
+
+    return NULL;
+}
+
+/**
+ * Merge the output range of a parallel merge part, from the auxiliary array to the array to be sorted.
+ *
+ * @param arg Pointer to the merge part.
+ * @return NULL.
+ */
+static void *merge_part_merge(void *arg) {
+    MergePart *part = arg;
+    const SortContext *ctx = part->ctx;
+    size_t size = ctx->size;
+    char *left = (char *) part->aux + part->low * size;
+    size_t n1 = part->mid - part->low + 1;
+    char *right = (char *) part->aux + (part->mid + 1) * size;
+    size_t n2 = part->high - part->mid;
+    // Find the ranges of the two halves that are merged to the output range
+    size_t i_begin = co_rank(ctx, left, n1, right, n2, part->begin);
+    size_t i_end = co_rank(ctx, left, n1, right, n2, part->end);
+    size_t j_begin = part->begin - i_begin;
+    size_t j_end = part->end - i_end;
+    merge_runs(ctx, (char *) part->base + (part->low + part->begin) * size, left + i_begin * size, i_end - i_begin,
+               right + j_begin * size, j_end - j_begin);
+
+    return NULL;
+}
+
+/**
+ * Merge the two sorted sub-arrays from low to mid and from mid + 1 to high using multiple threads. The output is split
+ * in equal ranges, and the elements of each half that end up in each range are found with a binary search.
+ *
+ * @param ctx The sort context.
+ * @param base The array to be sorted.
+ * @param aux The auxiliary array.
+ * @param low The index of the first array element to merge.
+ * @param mid The index of the element that splits the sorted halves.
+ * @param high The index of the last array element to merge.
+ * @param nthreads The number of threads to use.
+ */
+static void parallel_merge(const SortContext *ctx, void *base, void *aux, size_t low, size_t mid, size_t high,
+                           size_t nthreads) {
+    size_t n = high - low + 1;
+    MergePart *parts = malloc(nthreads * sizeof(MergePart));
+    if (!parts) {
+        // Merge with the calling thread
+        merge(ctx, base, aux, low, mid, high);
+        return;
+    }
+    for (size_t t = 0; t < nthreads; t++) {
+        parts[t] = (MergePart) {ctx, base, aux, low, mid, high, n / nthreads * t, n / nthreads * (t + 1)};
+    }
+    parts[nthreads - 1].end = n;
+    run_parallel(merge_part_copy, parts, nthreads, sizeof(MergePart));
+    run_parallel(merge_part_merge, parts, nthreads, sizeof(MergePart));
+    free(parts);
+}
+
+/**
+ * A task of the parallel merge sort.
+ */
+typedef struct {
+    /** The sort context. */
+    const SortContext *ctx;
+    /** The array to be sorted. */
+    void *base;
+    /** The auxiliary array. */
+    void *aux;
+    /** The index of the first array element to sort. */
+    size_t low;
+    /** The index of the last array element to sort. */
+    size_t high;
+    /** The number of threads to use. */
+    size_t nthreads;
+} MergeSortTask;
+
+/**
+ * Implement the merge sort on the array using multiple threads. The two halves are sorted in parallel, each with half
+ * of the threads, and are then merged with all the threads. Small arrays are sorted with the sequential merge sort.
+ *
+ * @param arg Pointer to the merge sort task.
+ * @return NULL.
+ */
+static void *parallel_merge_sort_impl(void *arg) {
+    MergeSortTask *task = arg;
+    const SortContext *ctx = task->ctx;
+    size_t size = ctx->size;
+    if (task->nthreads < 2 || task->high - task->low < PARALLEL_CUTOFF) {
+        merge_sort_impl(ctx, task->base, task->aux, task->low, task->high);
+        return NULL;
+    }
+    // Sort the two halves in parallel
+    size_t mid = task->low + (task->high - task->low) / 2;
+    MergeSortTask halves[2] = {
+        {ctx, task->base, task->aux, task->low, mid, task->nthreads - task->nthreads / 2},
+        {ctx, task->base, task->aux, mid + 1, task->high, task->nthreads / 2}
+    };
+    run_parallel(parallel_merge_sort_impl, halves, 2, sizeof(MergeSortTask));
+    // Check if the two sub-arrays are already sorted, so that we don't need to merge
+    if (compare_elements(ctx, (char *) task->base + (mid + 1) * size, (char *) task->base + mid * size) > 0) {
+        return NULL;
+    }
+    // Merge the sorted halves
+    parallel_merge(ctx, task->base, task->aux, task->low, mid, task->high, task->nthreads);
+
+    return NULL;
+}
+
+/**
+ * Sort an array using merge sort with multiple threads.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ * @param nthreads The number of threads to use, or zero to use one thread per online processor.
+ * @return true if the array was sorted, false if the auxiliary array could not be allocated.
+ */
+bool parallel_merge_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare, size_t nthreads) {
+    if (n < 2) {
+        return true;
+    }
+    SortContext ctx;
+    sort_context_init(&ctx, size, compare);
+    // Allocate the auxiliary array.
+    void *aux = malloc(n * size);
+    if (!aux) {
+        return false;
+    }
+    count_aux(&ctx, n * size);
+    // Sort the array
+    MergeSortTask task = {&ctx, base, aux, 0, n - 1, sort_threads(nthreads, n)};
+    parallel_merge_sort_impl(&task);
+    // Deallocate the auxiliary array.
+    free(aux);
+    // Assertion: The array must be sorted.
+    CHECK_SAMPLED(sorted(&ctx, base, n));
+
+    return true;
+}
+
+/**
+ * Partition the array to two parts: The left one (from low to p - 1) is less than or equal to the partitioning element
+ * (p) and the right one (from p + 1 to high) is greater than or equal to the partitioning element.
+ *
+ * @param ctx The sort context.
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param low The index of the first array element to sort.
+ * @param high The index of the last array element to sort.
+ * @return The index of the partitioning element.
+ */
+static size_t quick_sort_partition(const SortContext *ctx, void *base, size_t low, size_t high) {
+    size_t size = ctx->size;
+    size_t i = low;
+    size_t j = high + 1;
+
+    while (true) {
+        // Find the element on left to swap
+        while (compare_elements(ctx, (char *) base + (++i) * size, (char *) base + low * size) < 0) {
+            if (i == high) {
+                break;
+            }
+        }
+        // Find the element on right to swap
+        while (compare_elements(ctx, (char *) base + low * size, (char *) base + (--j) * size) < 0) {
+            if (j == low) {
+                break;
+            }
+        }
+        // Break if indexes crossed
+        if (i >= j) {
+            break;
+        }
+        swap(ctx, base, i, j);
+    }
+
+    // Put the partitioning element on its final position
+    swap(ctx, base, low, j);
+
+    return j;
+}
+
+/**
+ * Sift down an element of a heap that is stored in an array, until the max-heap invariant holds. The sift down is done
+ * bottom-up: the path of the larger children is followed down to a leaf with one comparison per level, and then it is
+ * climbed back up to the position of the element. Since the element usually belongs near the bottom, this takes about
+ * half the comparisons of the usual sift down, which compares the element with the larger child at each level.
+ *
+ * @param ctx The sort context.
+ * @param base A pointer to the first element of the heap.
+ * @param pos The index of the element to sift down.
+ * @param n The number of elements in the heap.
+ */
+static void heap_sift_down(const SortContext *ctx, void *base, size_t pos, size_t n) {
+    size_t size = ctx->size;
+    // Follow the larger children down to a leaf
+    size_t leaf = pos;
+    while (2 * leaf + 2 < n) {
+        size_t child = 2 * leaf + 1;
+        if (compare_elements(ctx, (char *) base + (child + 1) * size, (char *) base + child * size) > 0) {
+            child++;
+        }
+        leaf = child;
+    }
+    if (2 * leaf + 1 < n) {
+        leaf = 2 * leaf + 1;
+    }
+    // Climb up to the first element of the path that is not less than the element
+    while (leaf != pos && compare_elements(ctx, (char *) base + pos * size, (char *) base + leaf * size) > 0) {
+        leaf = (leaf - 1) / 2;
+    }
+    // Place the element there, and move the elements of the path above it one level up
+    for (size_t i = leaf; i != pos; i = (i - 1) / 2) {
+        swap(ctx, base, pos, i);
+    }
+}
+
+/**
+ * Sort an array using heap sort. Also used as the fallback of the quick sorts when the recursion becomes too deep.
+ *
+ * @param ctx The sort context.
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ */
+static void heap_sort_impl(const SortContext *ctx, void *base, size_t n) {
+    if (n < 2) {
+        return;
+    }
+    // Build the max heap
+    for (size_t i = n / 2; i-- > 0;) {
+        heap_sift_down(ctx, base, i, n);
+    }
+    // Move the maximum element to the end, and restore the heap
+    for (size_t i = n - 1; i > 0; i--) {
+        swap(ctx, base, 0, i);
+        heap_sift_down(ctx, base, 0, i);
+    }
+}
+
+/**
+ * Sort an array using heap sort.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ */
+void heap_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    SortContext ctx;
+    sort_context_init(&ctx, size, compare);
+    heap_sort_impl(&ctx, base, n);
+    // Assertion: The array must be sorted.
+    CHECK_SAMPLED(sorted(&ctx, base, n));
+}
+
+/**
+ * The state of smooth sort: the Leonardo numbers, and the orders of the Leonardo heaps that the array prefix is split
+ * to, from left to right.
+ */
+typedef struct {
+    /** The Leonardo numbers, which are the sizes of the heaps of each order */
+    size_t leonardo[SMOOTH_MAX_HEAPS];
+    /** The orders of the heaps */
+    unsigned char orders[SMOOTH_MAX_HEAPS];
+    /** The number of heaps */
+    size_t count;
+} SmoothSortState;
+
+/**
+ * Sift down the root of a Leonardo heap, until the max-heap invariant holds. The children of the root of a heap of
+ * order k are the heap of order k - 1 on its left and the heap of order k - 2 right before it.
+ *
+ * @param ctx The sort context.
+ * @param state The smooth sort state.
+ * @param base A pointer to the first element of the array.
+ * @param root The index of the root of the heap.
+ * @param order The order of the heap.
+ */
+static void smooth_sift_down(const SortContext *ctx, const SmoothSortState *state, void *base, size_t root,
+                             unsigned order) {
+    size_t size = ctx->size;
+    while (order >= 2) {
+        // Find the largest child
+        size_t right = root - 1;
+        size_t left = right - state->leonardo[order - 2];
+        size_t largest = left;
+        unsigned largest_order = order - 1;
+        if (compare_elements(ctx, (char *) base + right * size, (char *) base + left * size) > 0) {
+            largest = right;
+            largest_order = order - 2;
+        }
+        // Check if the element is smaller than the largest child
+        if (compare_elements(ctx, (char *) base + root * size, (char *) base + largest * size) >= 0) {
+            return;
+        }
+        swap(ctx, base, root, largest);
+        root = largest;
+        order = largest_order;
+    }
+}
+
+/**
+ * Restore the order of the roots of the Leonardo heaps, after the root of a heap has changed. The roots are kept in
+ * ascending order from left to right, so the root of the rightmost heap is the maximum of the prefix. The changed root
+ * is moved left past the roots that are greater than both itself and its children, and then it is sifted down in the
+ * heap where it stops. All the other heaps must be valid.
+ *
+ * @param ctx The sort context.
+ * @param state The smooth sort state.
+ * @param base A pointer to the first element of the array.
+ * @param heap The index of the heap whose root has changed.
+ * @param root The index of the root of the heap.
+ * @param valid true if the heap is valid, so its root is not compared to its children.
+ */
+static void smooth_rectify(const SortContext *ctx, const SmoothSortState *state, void *base, size_t heap, size_t root,
+                           bool valid) {
+    size_t size = ctx->size;
+    while (heap > 0) {
+        // Find the largest of the root and its children
+        unsigned order = state->orders[heap];
+        size_t largest = root;
+        if (!valid && order >= 2) {
+            size_t right = root - 1;
+            size_t left = right - state->leonardo[order - 2];
+            if (compare_elements(ctx, (char *) base + left * size, (char *) base + largest * size) > 0) {
+                largest = left;
+            }
+            if (compare_elements(ctx, (char *) base + right * size, (char *) base + largest * size) > 0) {
+                largest = right;
+            }
+        }
+        // Stop if the root of the previous heap is not greater
+        size_t previous = root - state->leonardo[order];
+        if (compare_elements(ctx, (char *) base + previous * size, (char *) base + largest * size) <= 0) {
+            break;
+        }
+        swap(ctx, base, previous, root);
+        root = previous;
+        heap--;
+        valid = false;
+    }
+    smooth_sift_down(ctx, state, base, root, state->orders[heap]);
+}
+
+/**
+ * Sort an array using smooth sort.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ */
+void smooth_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    SortContext ctx;
+    sort_context_init(&ctx, size, compare);
+    if (n < 2) {
+        return;
+    }
+    // Compute the Leonardo numbers, which stop growing at the maximum size
+    SmoothSortState state;
+    state.leonardo[0] = 1;
+    state.leonardo[1] = 1;
+    for (size_t i = 2; i < SMOOTH_MAX_HEAPS; i++) {
+        size_t sum = state.leonardo[i - 1] + state.leonardo[i - 2];
+        state.leonardo[i] = sum < state.leonardo[i - 1] || sum == SIZE_MAX ? SIZE_MAX : sum + 1;
+    }
+    // Add the elements to the heaps one at a time. Two heaps of consecutive orders are joined by the new element to a
+    // heap of the next order, otherwise the new element becomes a heap of order 1, or 0 if the last heap is of order 1.
+    state.count = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (state.count >= 2 && state.orders[state.count - 2] == state.orders[state.count - 1] + 1) {
+            state.count--;
+            state.orders[state.count - 1]++;
+        } else if (state.count >= 1 && state.orders[state.count - 1] == 1) {
+            state.orders[state.count++] = 0;
+        } else {
+            state.orders[state.count++] = 1;
+        }
+        // A heap that will be joined to a larger heap only has to be valid, and its root is ordered when it is split
+        unsigned order = state.orders[state.count - 1];
+        size_t remaining = n - 1 - i;
+        if ((state.count >= 2 && state.orders[state.count - 2] == order + 1 && remaining >= 1) ||
+            (order >= 1 && remaining > state.leonardo[order - 1])) {
+            smooth_sift_down(&ctx, &state, base, i, order);
+        } else {
+            smooth_rectify(&ctx, &state, base, state.count - 1, i, false);
+        }
+    }
+    // Remove the maximum, which is the root of the last heap, and split its heap to its children
+    for (size_t i = n - 1; i > 0; i--) {
+        unsigned order = state.orders[state.count - 1];
+        if (order < 2) {
+            state.count--;
+            continue;
+        }
+        size_t right = i - 1;
+        size_t left = right - state.leonardo[order - 2];
+        state.orders[state.count - 1] = (unsigned char) (order - 1);
+        state.orders[state.count++] = (unsigned char) (order - 2);
+        smooth_rectify(&ctx, &state, base, state.count - 2, left, true);
+        smooth_rectify(&ctx, &state, base, state.count - 1, right, true);
+    }
+    // Assertion: The array must be sorted.
+    CHECK_SAMPLED(sorted(&ctx, base, n));
+}
+
+/**
+ * Return the index of the median of three array elements.
+ *
+ * @param ctx The sort context.
+ * @param base A pointer to the first element of the array.
+ * @param i The index of the first element.
+ * @param j The index of the second element.
+ * @param k The index of the third element.
+ * @return The index of the median element.
+ */
+static size_t median_of_three(const SortContext *ctx, void *base, size_t i, size_t j, size_t k) {
+    size_t size = ctx->size;
+    char *a = (char *) base + i * size;
+    char *b = (char *) base + j * size;
+    char *c = (char *) base + k * size;
+    if (compare_elements(ctx, a, b) < 0) {
+        if (compare_elements(ctx, b, c) < 0) {
+            return j;
+        }
+        return compare_elements(ctx, a, c) < 0 ? k : i;
+    }
+    if (compare_elements(ctx, a, c) < 0) {
+        return i;
+    }
+    return compare_elements(ctx, b, c) < 0 ? k : j;
+}
+
+/**
+ * Select the partitioning element for the array from low to high and move it to position low. The median of three is
+ * used for small arrays, and Tukey's ninther for larger ones.
+ *
+ * @param ctx The sort context.
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param low The index of the first array element to sort.
+ * @param high The index of the last array element to sort.
+ */
+static void quick_sort_pivot(const SortContext *ctx, void *base, size_t low, size_t high) {
+    size_t n = high - low + 1;
+    size_t mid = low + n / 2;
+    size_t pivot;
+    if (n > NINTHER_THRESHOLD) {
+        size_t step = n / 8;
+        size_t first = median_of_three(ctx, base, low, low + step, low + 2 * step);
+        size_t second = median_of_three(ctx, base, mid - step, mid, mid + step);
+        size_t third = median_of_three(ctx, base, high - 2 * step, high - step, high);
+        pivot = median_of_three(ctx, base, first, second, third);
+    } else {
+        pivot = median_of_three(ctx, base, low, mid, high);
+    }
+    swap(ctx, base, low, pivot);
+}
+
+/**
+ * Implement quick sort on the array. The implementation is an introsort: when the recursion depth exceeds the depth
+ * limit, the sub-array is sorted with heap sort, so the running time is O(n log n) in the worst case. Only the smaller
+ * partition is sorted recursively, so the stack depth is O(log n).
+ *
+ * @param ctx The sort context.
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param low The index of the first array element to sort.
+ * @param high The index of the last array element to sort.
+ * @param depth The number of partitioning steps allowed before falling back to heap sort.
+ */
+static void quick_sort_impl(const SortContext *ctx, void *base, size_t low, size_t high, size_t depth) {
+    size_t size = ctx->size;
+    // The number of partitioning levels of this call, for the statistics
+    size_t levels = 0;
+    while (high >= low + CUTOFF) {
+        if (depth == 0) {
+            // Too many bad partitions, fall back to heap sort
+            heap_sort_impl(ctx, (char *) base + low * size, high - low + 1);
+            count_leave(ctx, levels);
+            return;
+        }
+        depth--;
+        count_enter(ctx);
+        levels++;
+        quick_sort_pivot(ctx, base, low, high);
+        size_t p = quick_sort_partition(ctx, base, low, high);
+        // Recurse on the smaller partition and loop on the larger one
+        if (p - low < high - p) {
+            if (low + 1 < p) {
+                quick_sort_impl(ctx, base, low, p - 1, depth);
+            }
+            low = p + 1;
+        } else {
+            if (p + 1 < high) {
+                quick_sort_impl(ctx, base, p + 1, high, depth);
+            }
+            high = p - 1;
+        }
+    }
+    // For small arrays, cutoff to insertion sort
+    if (low < high) {
+        insertion_sort_impl(ctx, (char *) base + low * size, high - low + 1);
+    }
+    count_leave(ctx, levels);
+}
+
+/**
+ * Return the depth limit of introsort for an array, which is two times the base two logarithm of its size.
+ *
+ * @param n The number of elements in the array.
+ * @return The depth limit.
+ */
+static size_t depth_limit(size_t n) {
+    size_t depth = 0;
+    while (n > 1) {
+        n /= 2;
+        depth++;
+    }
+
+    return 2 * depth;
+}
+
+/**
+ * Sort an array using quick sort.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ */
+void quick_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    SortContext ctx;
+    sort_context_init(&ctx, size, compare);
+    if (n < 2) {
+        return;
+    }
+    quick_sort_impl(&ctx, base, 0, n - 1, depth_limit(n));
+    // Assertion: The array must be sorted.
+    CHECK_SAMPLED(sorted(&ctx, base, n));
+}
+
+/**
+ * Partition the array to three parts with the Bentley-McIlroy partitioning: the elements less than the partitioning
+ * element, the elements equal to it, and the elements greater than it. During the partitioning, the elements equal to
+ * the partitioning element are kept at the two ends of the array, and they are swapped to the middle at the end.
+ *
+ * @param ctx The sort context.
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param low The index of the first array element to sort. It holds the partitioning element.
+ * @param high The index of the last array element to sort.
+ * @param lt Set to the index of the first element that is equal to the partitioning element.
+ * @param gt Set to the index of the last element that is equal to the partitioning element.
+ */
+static void quick_sort_3way_partition(const SortContext *ctx, void *base, size_t low, size_t high, size_t *lt,
+                                      size_t *gt) {
+    size_t size = ctx->size;
+    char *pivot = (char *) base + low * size;
+    size_t i = low;
+    size_t j = high + 1;
+    // The elements from low to p and from q to high are equal to the partitioning element
+    size_t p = low;
+    size_t q = high + 1;
+
+    while (true) {
+        // Find the element on left to swap
+        while (compare_elements(ctx, (char *) base + (++i) * size, pivot) < 0) {
+            if (i == high) {
+                break;
+            }
+        }
+        // Find the element on right to swap
+        while (compare_elements(ctx, pivot, (char *) base + (--j) * size) < 0) {
+            if (j == low) {
+                break;
+            }
+        }
+        // If the indexes met on an element equal to the partitioning element, move it to the left end
+        if (i == j && compare_elements(ctx, (char *) base + i * size, pivot) == 0) {
+            swap(ctx, base, ++p, i);
+        }
+        // Break if indexes crossed
+        if (i >= j) {
+            break;
+        }
+        swap(ctx, base, i, j);
+        // Move the elements equal to the partitioning element to the ends
+        if (compare_elements(ctx, (char *) base + i * size, pivot) == 0) {
+            swap(ctx, base, ++p, i);
+        }
+        if (compare_elements(ctx, (char *) base + j * size, pivot) == 0) {
+            swap(ctx, base, --q, j);
+        }
+    }
+
+    // Swap the equal elements from the ends to the middle. The less elements are from p + 1 to j, and the greater
+    // elements are from j + 1 to q - 1.
+    size_t less = j - p;
+    size_t greater = q - 1 - j;
+    size_t m = p - low + 1 < less ? p - low + 1 : less;
+    for (size_t k = 0; k < m; k++) {
+        swap(ctx, base, low + k, j + 1 - m + k);
+    }
+    m = high + 1 - q < greater ? high + 1 - q : greater;
+    for (size_t k = 0; k < m; k++) {
+        swap(ctx, base, j + 1 + k, high + 1 - m + k);
+    }
+    *lt = low + less;
+    *gt = high - greater;
+}
+
+/**
+ * Implement quick sort with three way partitioning on the array. The elements equal to the partitioning element are
+ * excluded from the recursion, so arrays with few distinct elements are sorted in linear time. As in quick_sort_impl,
+ * the sort falls back to heap sort when the recursion gets too deep.
+ *
+ * @param ctx The sort context.
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param low The index of the first array element to sort.
+ * @param high The index of the last array element to sort.
+ * @param depth The number of partitioning steps allowed before falling back to heap sort.
+ */
+static void quick_sort_3way_impl(const SortContext *ctx, void *base, size_t low, size_t high, size_t depth) {
+    size_t size = ctx->size;
+    // The number of partitioning levels of this call, for the statistics
+    size_t levels = 0;
+    while (high >= low + CUTOFF) {
+        if (depth == 0) {
+            // Too many bad partitions, fall back to heap sort
+            heap_sort_impl(ctx, (char *) base + low * size, high - low + 1);
+            count_leave(ctx, levels);
+            return;
+        }
+        depth--;
+        count_enter(ctx);
+        levels++;
+        quick_sort_pivot(ctx, base, low, high);
+        size_t lt;
+        size_t gt;
+        quick_sort_3way_partition(ctx, base, low, high, &lt, &gt);
+        // Recurse on the smaller partition and loop on the larger one
+        if (lt - low < high - gt) {
+            if (low + 1 < lt) {
+                quick_sort_3way_impl(ctx, base, low, lt - 1, depth);
+            }
+            low = gt + 1;
+        } else {
+            if (gt + 1 < high) {
+                quick_sort_3way_impl(ctx, base, gt + 1, high, depth);
+            }
+            if (lt == low) {
+                count_leave(ctx, levels);
+                return;
+            }
+            high = lt - 1;
+        }
+    }
+    // For small arrays, cutoff to insertion sort
+    if (low < high) {
+        insertion_sort_impl(ctx, (char *) base + low * size, high - low + 1);
+    }
+    count_leave(ctx, levels);
+}
+
+/**
+ * Sort an array using quick sort with three way partitioning.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ */
+void quick_sort_3way(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    SortContext ctx;
+    sort_context_init(&ctx, size, compare);
+    if (n < 2) {
+        return;
+    }
+    quick_sort_3way_impl(&ctx, base, 0, n - 1, depth_limit(n));
+    // Assertion: The array must be sorted.
+    CHECK_SAMPLED(sorted(&ctx, base, n));
+}
+
+/**
+ * A task of the parallel quick sort: a sub-array that remains to be sorted.
+ */
+typedef struct {
+    /** The index of the first array element to sort. */
+    size_t low;
+    /** The index of the last array element to sort. */
+    size_t high;
+    /** The number of partitioning steps allowed before falling back to heap sort. */
+    size_t depth;
+} QuickSortTask;
+
+/**
+ * A double ended queue of parallel quick sort tasks. The owner thread pushes and pops tasks at the bottom, and the
+ * other threads steal tasks from the top.
+ */
+typedef struct {
+    /** The lock protecting the queue. */
+    pthread_mutex_t lock;
+    /** The tasks. */
+    QuickSortTask *tasks;
+    /** The index of the top task. */
+    size_t top;
+    /** The index past the bottom task. */
+    size_t bottom;
+    /** The capacity of the tasks array. */
+    size_t capacity;
+} TaskDeque;
+
+/**
+ * The scheduler of the parallel quick sort.
+ */
+typedef struct {
+    /** The sort context. */
+    const SortContext *ctx;
+    /** The array to be sorted. */
+    void *base;
+    /** One task queue per thread. */
+    TaskDeque *deques;
+    /** The number of threads. */
+    size_t nthreads;
+    /** The number of tasks that have been pushed but not completed. */
+    atomic_size_t pending;
+} QuickSortScheduler;
+
+/**
+ * A worker thread of the parallel quick sort.
+ */
+typedef struct {
+    /** The scheduler. */
+    QuickSortScheduler *scheduler;
+    /** The index of the worker, which is also the index of its task queue. */
+    size_t index;
+} QuickSortWorker;
+
+/**
+ * Push a task to the bottom of a task queue.
+ *
+ * @param deque Pointer to the task queue.
+ * @param task The task to push.
+ * @return true if the task was pushed, false if the queue could not be resized.
+ */
+static bool task_deque_push(TaskDeque *deque, QuickSortTask task) {
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom == deque->capacity) {
+        // Move the tasks to the start of the array, or grow it if it is full
+        size_t count = deque->bottom - deque->top;
+        if (count < deque->capacity / 2) {
+            memmove(deque->tasks, deque->tasks + deque->top, count * sizeof(QuickSortTask));
+        } else {
+            QuickSortTask *tasks = malloc(2 * deque->capacity * sizeof(QuickSortTask));
+            if (!tasks) {
+                pthread_mutex_unlock(&deque->lock);
+                return false;
+            }
+            memcpy(tasks, deque->tasks + deque->top, count * sizeof(QuickSortTask));
+            free(deque->tasks);
+            deque->tasks = tasks;
+            deque->capacity *= 2;
+        }
+        deque->top = 0;
+        deque->bottom = count;
+    }
+    deque->tasks[deque->bottom++] = task;
+    pthread_mutex_unlock(&deque->lock);
+
+    return true;
+}
+
+/**
+ * Pop a task from the bottom or the top of a task queue.
+ *
+ * @param deque Pointer to the task queue.
+ * @param task Set to the popped task.
+ * @param steal true to pop the task from the top, false to pop it from the bottom.
+ * @return true if a task was popped, false if the queue is empty.
+ */
+static bool task_deque_pop(TaskDeque *deque, QuickSortTask *task, bool steal) {
+    pthread_mutex_lock(&deque->lock);
+    bool found = deque->top < deque->bottom;
+    if (found) {
+        *task = steal ? deque->tasks[deque->top++] : deque->tasks[--deque->bottom];
+    }
+    pthread_mutex_unlock(&deque->lock);
+
+    return found;
+}
+
+/**
+ * Run a parallel quick sort task. The sub-array is partitioned until it is smaller than the parallel cutoff. After
+ * each partitioning step, the larger partition is pushed to the task queue of the worker, so that other workers can
+ * steal it, and the worker continues with the smaller one. The final sub-array is sorted with the sequential quick
+ * sort.
+ *
+ * @param worker Pointer to the worker.
+ * @param task The task to run.
+ */
+static void parallel_quick_sort_task(QuickSortWorker *worker, QuickSortTask task) {
+    QuickSortScheduler *scheduler = worker->scheduler;
+    const SortContext *ctx = scheduler->ctx;
+    while (task.high - task.low >= PARALLEL_CUTOFF && task.depth > 0) {
+        task.depth--;
+        quick_sort_pivot(ctx, scheduler->base, task.low, task.high);
+        size_t p = quick_sort_partition(ctx, scheduler->base, task.low, task.high);
+        if (p == task.low || p == task.high) {
+            // One of the partitions is empty, so continue with the other one
+            task.low = p == task.low ? p + 1 : task.low;
+            task.high = p == task.high ? p - 1 : task.high;
+            continue;
+        }
+        QuickSortTask left = {task.low, p - 1, task.depth};
+        QuickSortTask right = {p + 1, task.high, task.depth};
+        bool left_smaller = p - task.low < task.high - p;
+        QuickSortTask larger = left_smaller ? right : left;
+        task = left_smaller ? left : right;
+        atomic_fetch_add(&scheduler->pending, 1);
+        if (!task_deque_push(&scheduler->deques[worker->index], larger)) {
+            // The task could not be queued, so sort it here
+            quick_sort_impl(ctx, scheduler->base, larger.low, larger.high, larger.depth);
+            atomic_fetch_sub(&scheduler->pending, 1);
+        }
+    }
+    if (task.low < task.high) {
+        quick_sort_impl(ctx, scheduler->base, task.low, task.high, task.depth);
+    }
+    atomic_fetch_sub(&scheduler->pending, 1);
+}
+
+/**
+ * The main loop of a parallel quick sort worker. The worker runs the tasks of its own queue, and when it is empty,
+ * steals tasks from the queues of the other workers. It stops when no tasks are pending.
+ *
+ * @param arg Pointer to the worker.
+ * @return NULL.
+ */
+static void *parallel_quick_sort_worker(void *arg) {
+    QuickSortWorker *worker = arg;
+    QuickSortScheduler *scheduler = worker->scheduler;
+    while (atomic_load(&scheduler->pending) > 0) {
+        QuickSortTask task;
+        bool found = task_deque_pop(&scheduler->deques[worker->index], &task, false);
+        for (size_t i = 1; !found && i < scheduler->nthreads; i++) {
+            size_t victim = (worker->index + i) % scheduler->nthreads;
+            found = task_deque_pop(&scheduler->deques[victim], &task, true);
+        }
+        if (found) {
+            parallel_quick_sort_task(worker, task);
+        } else {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Sort an array using quick sort with multiple threads.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ * @param nthreads The number of threads to use, or zero to use one thread per online processor.
+ */
+void parallel_quick_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare, size_t nthreads) {
+    if (n < 2) {
+        return;
+    }
+    SortContext ctx;
+    sort_context_init(&ctx, size, compare);
+    nthreads = sort_threads(nthreads, n);
+    if (nthreads < 2 || n <= PARALLEL_CUTOFF) {
+        quick_sort_impl(&ctx, base, 0, n - 1, depth_limit(n));
+        return;
+    }
+
+    // Create the task queues
+    QuickSortScheduler scheduler = {.ctx = &ctx, .base = base, .nthreads = nthreads};
+    QuickSortWorker *workers = malloc(nthreads * sizeof(QuickSortWorker));
+    scheduler.deques = malloc(nthreads * sizeof(TaskDeque));
+    size_t created = 0;
+    if (workers && scheduler.deques) {
+        for (; created < nthreads; created++) {
+            TaskDeque *deque = &scheduler.deques[created];
+            deque->capacity = 64;
+            deque->tasks = malloc(deque->capacity * sizeof(QuickSortTask));
+            if (!deque->tasks) {
+                break;
+            }
+            pthread_mutex_init(&deque->lock, NULL);
+            deque->top = 0;
+            deque->bottom = 0;
+            workers[created] = (QuickSortWorker) {&scheduler, created};
+        }
+    }
+
+    if (created == nthreads) {
+        // Push the whole array as the first task and start the workers
+        QuickSortTask task = {0, n - 1, depth_limit(n)};
+        atomic_init(&scheduler.pending, 1);
+        task_deque_push(&scheduler.deques[0], task);
+        run_parallel(parallel_quick_sort_worker, workers, nthreads, sizeof(QuickSortWorker));
+    } else {
+        // Could not allocate the workers or the task queues, so sort the array sequentially
+        quick_sort_impl(&ctx, base, 0, n - 1, depth_limit(n));
+    }
+
+    // Destroy the task queues
+    for (size_t i = 0; i < created; i++) {
+        pthread_mutex_destroy(&scheduler.deques[i].lock);
+        free(scheduler.deques[i].tasks);
+    }
+    free(scheduler.deques);
+    free(workers);
+    // Assertion: The array must be sorted.
+    CHECK_SAMPLED(sorted(&ctx, base, n));
+}
+
+static void quick_select_impl(const SortContext *ctx, void *base, size_t low, size_t high, size_t k, size_t depth);
+
+/**
+ * Select the median of medians of the array from low to high as the partitioning element, and move it to position
+ * low. The array is split in groups of five elements, the medians of the groups are moved to the start of the array,
+ * and their median is selected recursively. At least 30% of the elements are less than or equal to the partitioning
+ * element, and at least 30% are greater than or equal to it, so the selection runs in linear time in the worst case.
+ *
+ * @param ctx The sort context.
+ * @param base A pointer to the first element of the array.
+ * @param low The index of the first array element.
+ * @param high The index of the last array element.
+ */
+static void median_of_medians(const SortContext *ctx, void *base, size_t low, size_t high) {
+    size_t size = ctx->size;
+    size_t medians = 0;
+    for (size_t i = low; i <= high; i += 5) {
+        size_t n = high - i + 1 < 5 ? high - i + 1 : 5;
+        insertion_sort_impl(ctx, (char *) base + i * size, n);
+        swap(ctx, base, low + medians, i + n / 2);
+        medians++;
+    }
+    size_t mid = low + medians / 2;
+    quick_select_impl(ctx, base, low, low + medians - 1, mid, 0);
+    swap(ctx, base, low, mid);
+}
+
+/**
+ * Implement quick select on the array. The implementation is an introselect: the partitioning element is selected as
+ * in quick sort, and when the number of partitioning steps exceeds the depth limit, the median of medians is used
+ * instead, so the running time is linear in the worst case.
+ *
+ * @param ctx The sort context.
+ * @param base A pointer to the first element of the array.
+ * @param low The index of the first array element.
+ * @param high The index of the last array element.
+ * @param k The index of the element to select.
+ * @param depth The number of partitioning steps allowed before falling back to the median of medians.
+ */
+static void quick_select_impl(const SortContext *ctx, void *base, size_t low, size_t high, size_t k, size_t depth) {
+    size_t size = ctx->size;
+    // The number of partitioning levels of this call, for the statistics
+    size_t levels = 0;
+    while (high >= low + CUTOFF) {
+        if (depth == 0) {
+            // Too many bad partitions, select a partitioning element that guarantees a good split
+            median_of_medians(ctx, base, low, high);
+        } else {
+            depth--;
+            quick_sort_pivot(ctx, base, low, high);
+        }
+        size_t p = quick_sort_partition(ctx, base, low, high);
+        count_enter(ctx);
+        levels++;
+        // Continue only on the partition that contains the element
+        if (k == p) {
+            count_leave(ctx, levels);
+            return;
+        } else if (k < p) {
+            high = p - 1;
+        } else {
+            low = p + 1;
+        }
+    }
+    // For small arrays, cutoff to insertion sort
+    if (low < high) {
+        insertion_sort_impl(ctx, (char *) base + low * size, high - low + 1);
+    }
+    count_leave(ctx, levels);
+}
+
+/**
+ * Rearrange an array so that the element at position k is the one that would be in that position if the array was
+ * sorted.
+ *
+ * @param base A pointer to the first element of the array.
+ * @param n The number of elements in the array pointed by base.
+ * @param k The index of the element to select.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ */
+void quick_select(void *base, size_t n, size_t k, size_t size, COMPARE_FUNC compare) {
+    SortContext ctx;
+    sort_context_init(&ctx, size, compare);
+    if (k >= n) {
+        return;
+    }
+    quick_select_impl(&ctx, base, 0, n - 1, k, depth_limit(n));
+    // Assertion: The array must be partitioned around the selected element.
+    CHECK_SAMPLED(partitioned(&ctx, base, n, k));
+}
+
+/**
+ * Sort the k smallest elements of an array to its start.
+ *
+ * @param base A pointer to the first element of the array.
+ * @param n The number of elements in the array pointed by base.
+ * @param k The number of elements to sort.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ */
+void partial_sort(void *base, size_t n, size_t k, size_t size, COMPARE_FUNC compare) {
+    SortContext ctx;
+    sort_context_init(&ctx, size, compare);
+    if (k > n) {
+        k = n;
+    }
+    if (k == 0) {
+        return;
+    }
+    // Move the k smallest elements to the start, with the largest of them last, and sort the rest of them
+    quick_select_impl(&ctx, base, 0, n - 1, k - 1, depth_limit(n));
+    if (k > 2) {
+        quick_sort_impl(&ctx, base, 0, k - 2, depth_limit(k - 1));
+    }
+    // Assertion: The first k elements must be sorted.
+    CHECK_SAMPLED(sorted(&ctx, base, k));
+}
+
+/**
+ * Copy the k smallest elements of an array to a destination array, in sorted order.
+ *
+ * @param dest A pointer to the first element of the destination array, which must have room for k elements.
+ * @param base A pointer to the first element of the array.
+ * @param n The number of elements in the array pointed by base.
+ * @param k The number of elements to copy.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ * @return The number of elements copied, which is the minimum of k and n.
+ */
+size_t top_k(void *dest, const void *base, size_t n, size_t k, size_t size, COMPARE_FUNC compare) {
+    SortContext ctx;
+    sort_context_init(&ctx, size, compare);
+    if (k > n) {
+        k = n;
+    }
+    if (k == 0) {
+        return 0;
+    }
+    // Build a max heap of the first k elements
+    count_moves(&ctx, k);
+    memcpy(dest, base, k * size);
+    for (size_t i = k / 2; i-- > 0;) {
+        heap_sift_down(&ctx, dest, i, k);
+    }
+    // Replace the maximum element of the heap with any smaller element
+    for (size_t i = k; i < n; i++) {
+        const char *element = (const char *) base + i * size;
+        if (compare_elements(&ctx, element, dest) < 0) {
+            set(&ctx, dest, element);
+            heap_sift_down(&ctx, dest, 0, k);
+        }
+    }
+    // Move the maximum element to the end, and restore the heap
+    for (size_t i = k - 1; i > 0; i--) {
+        swap(&ctx, dest, 0, i);
+        heap_sift_down(&ctx, dest, 0, i);
+    }
+    // Assertion: The destination array must be sorted.
+    CHECK_SAMPLED(sorted(&ctx, dest, k));
+
+    return k;
+}
+
+/**
+ * Sort an array with insertion sort, for the pattern-defeating quick sort. If the array is not the leftmost part of
+ * the array being sorted, the element before it is known to be less than or equal to all of its elements, so it can be
+ * used as a sentinel and the bounds check on the inner loop is omitted.
+ *
+ * @param ctx The sort context.
+ * @param begin A pointer to the first element of the array to be sorted.
+ * @param end A pointer past the last element of the array to be sorted.
+ * @param leftmost true if the array is the leftmost part of the array being sorted.
+ */
+static void pdq_insertion_sort(const SortContext *ctx, char *begin, char *end, bool leftmost) {
+    size_t size = ctx->size;
+    char temp[size];
+    for (char *current = begin + size; current < end; current += size) {
+        char *sift = current;
+        if (compare_elements(ctx, sift, sift - size) < 0) {
+            set(ctx, temp, sift);
+            do {
+                set(ctx, sift, sift - size);
+                sift -= size;
+            } while ((!leftmost || sift != begin) && compare_elements(ctx, temp, sift - size) < 0);
+            set(ctx, sift, temp);
+        }
+    }
+}
+
+/**
+ * Attempt to sort an array with insertion sort, but give up if more than PDQ_PARTIAL_INSERTION_LIMIT elements have to
+ * be moved.
+ *
+ * @param ctx The sort context.
+ * @param begin A pointer to the first element of the array to be sorted.
+ * @param end A pointer past the last element of the array to be sorted.
+ * @return true if the array was sorted, false otherwise.
+ */
+static bool pdq_partial_insertion_sort(const SortContext *ctx, char *begin, char *end) {
+    size_t size = ctx->size;
+    char temp[size];
+    size_t limit = 0;
+    for (char *current = begin + size; current < end; current += size) {
+        char *sift = current;
+        if (compare_elements(ctx, sift, sift - size) < 0) {
+            set(ctx, temp, sift);
+            do {
+                set(ctx, sift, sift - size);
+                sift -= size;
+            } while (sift != begin && compare_elements(ctx, temp, sift - size) < 0);
+            set(ctx, sift, temp);
+            limit += (size_t) (current - sift) / size;
+        }
+        if (limit > PDQ_PARTIAL_INSERTION_LIMIT) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Sort three array elements in place.
+ *
+ * @param ctx The sort context.
+ * @param a Pointer to the first element.
+ * @param b Pointer to the second element.
+ * @param c Pointer to the third element.
+ */
+static void pdq_sort3(const SortContext *ctx, char *a, char *b, char *c) {
+    if (compare_elements(ctx, b, a) < 0) {
+        swap_elements(ctx, a, b);
+    }
+    if (compare_elements(ctx, c, b) < 0) {
+        swap_elements(ctx, b, c);
+        if (compare_elements(ctx, b, a) < 0) {
+            swap_elements(ctx, a, b);
+        }
+    }
+}
+
+/**
+ * Swap the elements found during block partitioning. The elements at first + offsets_l[i] * size are swapped with the
+ * elements at last - offsets_r[i] * size. If the number of elements to swap differ between the two sides, a cyclic
+ * permutation is used instead, which needs fewer moves.
+ *
+ * @param ctx The sort context.
+ * @param first The base of the left offsets.
+ * @param last The base of the right offsets.
+ * @param offsets_l The offsets of the left elements.
+ * @param offsets_r The offsets of the right elements.
+ * @param num The number of elements to swap.
+ * @param use_swaps true to use plain swaps.
+ */
+static void pdq_swap_offsets(const SortContext *ctx, char *first, char *last, const unsigned char *offsets_l,
+                             const unsigned char *offsets_r, size_t num, bool use_swaps) {
+    size_t size = ctx->size;
+    if (use_swaps) {
+        for (size_t i = 0; i < num; i++) {
+            swap_elements(ctx, first + offsets_l[i] * size, last - offsets_r[i] * size);
+        }
+    } else if (num > 0) {
+        char temp[size];
+        char *l = first + offsets_l[0] * size;
+        char *r = last - offsets_r[0] * size;
+        set(ctx, temp, l);
+        set(ctx, l, r);
+        for (size_t i = 1; i < num; i++) {
+            l = first + offsets_l[i] * size;
+            set(ctx, r, l);
+            r = last - offsets_r[i] * size;
+            set(ctx, l, r);
+        }
+        set(ctx, r, temp);
+    }
+}
+
+/**
+ * Partition the array around the first element, using block partitioning: the comparison results for a block of
+ * elements on each side are first recorded in offset buffers without branching, and the misplaced elements are swapped
+ * afterwards. Elements equal to the partitioning element go to the right partition.
+ *
+ * @param ctx The sort context.
+ * @param begin A pointer to the first element of the array to be partitioned.
+ * @param end A pointer past the last element of the array to be partitioned.
+ * @param already_partitioned Set to true if the array was already partitioned.
+ * @return A pointer to the partitioning element in its final position.
+ */
+static char *pdq_partition_right(const SortContext *ctx, char *begin, char *end, bool *already_partitioned) {
+    size_t size = ctx->size;
+    char pivot[size];
+    set(ctx, pivot, begin);
+    char *first = begin;
+    char *last = end;
+
+    // Find the first element greater than or equal to the pivot. The median of three guarantees that it exists.
+    do {
+        first += size;
+    } while (compare_elements(ctx, first, pivot) < 0);
+    // Find the last element less than the pivot. If no element was moved, guard against running past first.
+    if (first - size == begin) {
+        while (first < last) {
+            last -= size;
+            if (compare_elements(ctx, last, pivot) < 0) {
+                break;
+            }
+        }
+    } else {
+        do {
+            last -= size;
+        } while (compare_elements(ctx, last, pivot) >= 0);
+    }
+
+    // If the pointers crossed, no element needs to be moved
+    *already_partitioned = first >= last;
+    if (!*already_partitioned) {
+        swap_elements(ctx, first, last);
+        first += size;
+
+        unsigned char offsets_l[PDQ_BLOCK_SIZE];
+        unsigned char offsets_r[PDQ_BLOCK_SIZE];
+        char *offsets_l_base = first;
+        char *offsets_r_base = last;
+        size_t num_l = 0, num_r = 0, start_l = 0, start_r = 0;
+        while (first < last) {
+            // Fill the offset blocks for the side(s) that have been exhausted
+            size_t num_unknown = (size_t) (last - first) / size;
+            size_t left_split = num_l == 0 ? (num_r == 0 ? num_unknown / 2 : num_unknown) : 0;
+            size_t right_split = num_r == 0 ? (num_unknown - left_split) : 0;
+            if (left_split > PDQ_BLOCK_SIZE) {
+                left_split = PDQ_BLOCK_SIZE;
+            }
+            if (right_split > PDQ_BLOCK_SIZE) {
+                right_split = PDQ_BLOCK_SIZE;
+            }
+            for (size_t i = 0; i < left_split; i++) {
+                offsets_l[num_l] = (unsigned char) i;
+                num_l += compare_elements(ctx, first, pivot) >= 0;
+                first += size;
+            }
+            for (size_t i = 0; i < right_split; i++) {
+                offsets_r[num_r] = (unsigned char) (i + 1);
+                last -= size;
+                num_r += compare_elements(ctx, last, pivot) < 0;
+            }
+
+            // Swap the misplaced elements
+            size_t num = num_l < num_r ? num_l : num_r;
+            pdq_swap_offsets(ctx, offsets_l_base, offsets_r_base, offsets_l + start_l, offsets_r + start_r, num,
+                             num_l == num_r);
+            num_l -= num;
+            num_r -= num;
+            start_l += num;
+            start_r += num;
+            if (num_l == 0) {
+                start_l = 0;
+                offsets_l_base = first;
+            }
+            if (num_r == 0) {
+                start_r = 0;
+                offsets_r_base = last;
+            }
+        }
+
+        // Place the remaining misplaced elements of the non exhausted side next to the partition point
+        if (num_l > 0) {
+            while (num_l-- > 0) {
+                last -= size;
+                swap_elements(ctx, offsets_l_base + offsets_l[start_l + num_l] * size, last);
+            }
+            first = last;
+        }
+        if (num_r > 0) {
+            while (num_r-- > 0) {
+                swap_elements(ctx, offsets_r_base - offsets_r[start_r + num_r] * size, first);
+                first += size;
+            }
+            last = first;
+        }
+    }
+
+    // Put the partitioning element on its final position
+    char *pivot_pos = first - size;
+    set(ctx, begin, pivot_pos);
+    set(ctx, pivot_pos, pivot);
+
+    return pivot_pos;
+}
+
+/**
+ * Partition the array around the first element, putting the elements equal to it to the left partition. This is used
+ * when the partitioning element is equal to the element preceding the array, so all the elements of the left partition
+ * are equal and do not need to be sorted.
+ *
+ * @param ctx The sort context.
+ * @param begin A pointer to the first element of the array to be partitioned.
+ * @param end A pointer past the last element of the array to be partitioned.
+ * @return A pointer to the partitioning element in its final position.
+ */
+static char *pdq_partition_left(const SortContext *ctx, char *begin, char *end) {
+    size_t size = ctx->size;
+    char pivot[size];
+    set(ctx, pivot, begin);
+    char *first = begin;
+    char *last = end;
+
+    do {
+        last -= size;
+    } while (compare_elements(ctx, pivot, last) < 0);
+    if (last + size == end) {
+        while (first < last) {
+            first += size;
+            if (compare_elements(ctx, pivot, first) < 0) {
+                break;
+            }
+        }
+    } else {
+        do {
+            first += size;
+        } while (compare_elements(ctx, pivot, first) >= 0);
+    }
+
+    while (first < last) {
+        swap_elements(ctx, first, last);
+        do {
+            last -= size;
+        } while (compare_elements(ctx, pivot, last) < 0);
+        do {
+            first += size;
+        } while (compare_elements(ctx, pivot, first) >= 0);
+    }
+
+    // Put the partitioning element on its final position
+    set(ctx, begin, last);
+    set(ctx, last, pivot);
+
+    return last;
+}
+
+/**
+ * Shuffle some elements of a partition that turned out to be highly unbalanced, in order to break patterns in the
+ * input that cause bad partitioning element choices.
+ *
+ * @param ctx The sort context.
+ * @param begin A pointer to the first element of the partition.
+ * @param end A pointer past the last element of the partition.
+ */
+static void pdq_break_patterns(const SortContext *ctx, char *begin, char *end) {
+    size_t size = ctx->size;
+    size_t n = (size_t) (end - begin) / size;
+    if (n < PDQ_INSERTION_THRESHOLD) {
+        return;
+    }
+    size_t quarter = n / 4;
+    swap_elements(ctx, begin, begin + quarter * size);
+    swap_elements(ctx, end - size, end - quarter * size);
+    if (n > NINTHER_THRESHOLD) {
+        swap_elements(ctx, begin + size, begin + (quarter + 1) * size);
+        swap_elements(ctx, begin + 2 * size, begin + (quarter + 2) * size);
+        swap_elements(ctx, end - 2 * size, end - (quarter + 1) * size);
+        swap_elements(ctx, end - 3 * size, end - (quarter + 2) * size);
+    }
+}
+
+/**
+ * Implement pattern-defeating quick sort on the array.
+ *
+ * @param ctx The sort context.
+ * @param begin A pointer to the first element of the array to be sorted.
+ * @param end A pointer past the last element of the array to be sorted.
+ * @param bad_allowed The number of highly unbalanced partitions allowed before falling back to heap sort.
+ * @param leftmost true if the array is the leftmost part of the array being sorted.
+ */
+static void pdq_sort_impl(const SortContext *ctx, char *begin, char *end, size_t bad_allowed, bool leftmost) {
+    size_t size = ctx->size;
+    // The number of partitioning levels of this call, for the statistics
+    size_t levels = 0;
+    while (true) {
+        size_t n = (size_t) (end - begin) / size;
+        // For small arrays, cutoff to insertion sort
+        if (n < PDQ_INSERTION_THRESHOLD) {
+            pdq_insertion_sort(ctx, begin, end, leftmost);
+            count_leave(ctx, levels);
+            return;
+        }
+
+        // Select the partitioning element and move it to the start of the array
+        size_t half = n / 2;
+        if (n > NINTHER_THRESHOLD) {
+            pdq_sort3(ctx, begin, begin + half * size, end - size);
+            pdq_sort3(ctx, begin + size, begin + (half - 1) * size, end - 2 * size);
+            pdq_sort3(ctx, begin + 2 * size, begin + (half + 1) * size, end - 3 * size);
+            pdq_sort3(ctx, begin + (half - 1) * size, begin + half * size, begin + (half + 1) * size);
+            swap_elements(ctx, begin, begin + half * size);
+        } else {
+            pdq_sort3(ctx, begin + half * size, begin, end - size);
+        }
+
+        // If the partitioning element is equal to the element before the array, all the elements equal to it can be
+        // put in the left partition, which is then already sorted.
+        if (!leftmost && compare_elements(ctx, begin - size, begin) >= 0) {
+            begin = pdq_partition_left(ctx, begin, end) + size;
+            count_enter(ctx);
+            levels++;
+            continue;
+        }
+
+        bool already_partitioned;
+        char *pivot_pos = pdq_partition_right(ctx, begin, end, &already_partitioned);
+        count_enter(ctx);
+        levels++;
+        size_t l_size = (size_t) (pivot_pos - begin) / size;
+        size_t r_size = (size_t) (end - (pivot_pos + size)) / size;
+        if (l_size < n / 8 || r_size < n / 8) {
+            // Too many bad partitions, fall back to heap sort
+            if (--bad_allowed == 0) {
+                heap_sort_impl(ctx, begin, n);
+                count_leave(ctx, levels);
+                return;
+            }
+            pdq_break_patterns(ctx, begin, pivot_pos);
+            pdq_break_patterns(ctx, pivot_pos + size, end);
+        } else if (already_partitioned &&
+                   pdq_partial_insertion_sort(ctx, begin, pivot_pos) &&
+                   pdq_partial_insertion_sort(ctx, pivot_pos + size, end)) {
+            // The array was already partitioned and both sides were almost sorted
+            count_leave(ctx, levels);
+            return;
+        }
+
+        // Sort the left partition recursively and the right one iteratively
+        pdq_sort_impl(ctx, begin, pivot_pos, bad_allowed, leftmost);
+        begin = pivot_pos + size;
+        leftmost = false;
+    }
+}
+
+/**
+ * Sort an array using pattern-defeating quick sort.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ */
+void pdq_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    SortContext ctx;
+    sort_context_init(&ctx, size, compare);
+    if (n < 2) {
+        return;
+    }
+    pdq_sort_impl(&ctx, base, (char *) base + n * size, depth_limit(n) / 2, true);
+    // Assertion: The array must be sorted.
+    CHECK_SAMPLED(sorted(&ctx, base, n));
+}
+
+/**
+ * The state of a tim sort call.
+ */
+typedef struct {
+    /** The sort context. */
+    const SortContext *ctx;
+    /** The temporary array, large enough to hold half of the array. */
+    char *tmp;
+    /** The number of consecutive wins of a run after which merging switches to galloping. */
+    size_t min_gallop;
+    /** The number of pending runs. */
+    size_t nruns;
+    /** The first element of each pending run. */
+    char *run_base[TIM_MAX_RUNS];
+    /** The number of elements of each pending run. */
+    size_t run_len[TIM_MAX_RUNS];
+} TimSortState;
+
+/**
+ * Compute the minimum run length for an array. Runs shorter than this are extended with binary insertion sort, so that
+ * the number of runs is a power of two or slightly less.
+ *
+ * @param n The number of elements in the array.
+ * @return The minimum run length.
+ */
+static size_t tim_min_run(size_t n) {
+    size_t odd = 0;
+    while (n >= TIM_MIN_MERGE) {
+        odd |= n & 1;
+        n >>= 1;
+    }
+
+    return n + odd;
+}
+
+/**
+ * Find the length of the run that starts at the beginning of the array. A run is either non-descending, or strictly
+ * descending, in which case it is reversed. Strictly descending runs can be reversed without breaking stability.
+ *
+ * @param ctx The sort context.
+ * @param base A pointer to the first element of the array.
+ * @param n The number of elements in the array.
+ * @return The length of the run.
+ */
+static size_t tim_count_run(const SortContext *ctx, char *base, size_t n) {
+    size_t size = ctx->size;
+    if (n < 2) {
+        return n;
+    }
+    size_t length = 2;
+    if (compare_elements(ctx, base + size, base) < 0) {
+        while (length < n && compare_elements(ctx, base + length * size, base + (length - 1) * size) < 0) {
+            length++;
+        }
+        for (size_t i = 0, j = length - 1; i < j; i++, j--) {
+            swap(ctx, base, i, j);
+        }
+    } else {
+        while (length < n && compare_elements(ctx, base + length * size, base + (length - 1) * size) >= 0) {
+            length++;
+        }
+    }
+
+    return length;
+}
+
+/**
+ * Sort an array with binary insertion sort, given that a prefix of the array is already sorted.
+ *
+ * @param ctx The sort context.
+ * @param base A pointer to the first element of the array.
+ * @param n The number of elements in the array.
+ * @param start The number of elements at the start of the array that are already sorted.
+ */
+static void tim_binary_insertion_sort(const SortContext *ctx, char *base, size_t n, size_t start) {
+    size_t size = ctx->size;
+    char pivot[size];
+    for (size_t i = start; i < n; i++) {
+        set(ctx, pivot, base + i * size);
+        // Insert after the elements that are equal, so that the sort is stable
+        size_t low = 0;
+        size_t high = i;
+        while (low < high) {
+            size_t mid = low + (high - low) / 2;
+            if (compare_elements(ctx, pivot, base + mid * size) < 0) {
+                high = mid;
+            } else {
+                low = mid + 1;
+            }
+        }
+        count_moves(ctx, i - low);
+        memmove(base + (low + 1) * size, base + low * size, (i - low) * size);
+        set(ctx, base + low * size, pivot);
+    }
+}
+
+/**
+ * Find the position where a key should be inserted in a sorted array, by galloping from a hint and then by binary
+ * search. The search takes a logarithmic number of comparisons in the distance between the hint and the result.
+ *
+ * @param ctx The sort context.
+ * @param key Pointer to the key.
+ * @param base A pointer to the first element of the sorted array.
+ * @param n The number of elements in the array.
+ * @param hint The index where the search starts.
+ * @param right Whether the key is inserted after the elements that are equal to it, instead of before them.
+ * @return The number of elements that are placed before the key.
+ */
+static size_t tim_gallop(const SortContext *ctx, const void *key, const char *base, size_t n, size_t hint, bool right) {
+    size_t size = ctx->size;
+    size_t last = 0;
+    size_t offset = 1;
+    size_t low;
+    size_t high;
+    int before = right ? 0 : -1;
+    if (compare_elements(ctx, base + hint * size, key) <= before) {
+        // Gallop to the right until an element that is placed after the key is found
+        size_t max_offset = n - hint;
+        while (offset < max_offset && compare_elements(ctx, base + (hint + offset) * size, key) <= before) {
+            last = offset;
+            offset = 2 * offset + 1;
+        }
+        if (offset > max_offset) {
+            offset = max_offset;
+        }
+        low = hint + last + 1;
+        high = hint + offset;
+    } else {
+        // Gallop to the left until an element that is placed before the key is found
+        size_t max_offset = hint + 1;
+        while (offset < max_offset && compare_elements(ctx, base + (hint - offset) * size, key) > before) {
+            last = offset;
+            offset = 2 * offset + 1;
+        }
+        if (offset > max_offset) {
+            offset = max_offset;
+        }
+        low = hint + 1 - offset;
+        high = hint - last;
+    }
+    // The position is between low and high
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (compare_elements(ctx, base + mid * size, key) <= before) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/**
+ * Merge two adjacent runs, when the left run is not longer than the right one. The left run is copied to the temporary
+ * array and the runs are merged from the start. The first element of the right run must be placed before the left run,
+ * and the last element of the left run must be placed after the right run.
+ *
+ * @param state The tim sort state.
+ * @param left The left run.
+ * @param n1 The number of elements in the left run.
+ * @param right The right run, which follows the left run.
+ * @param n2 The number of elements in the right run.
+ */
+static void tim_merge_low(TimSortState *state, char *left, size_t n1, char *right, size_t n2) {
+    const SortContext *ctx = state->ctx;
+    size_t size = ctx->size;
+    count_moves(ctx, n1);
+    memcpy(state->tmp, left, n1 * size);
+    char *i = state->tmp;
+    char *j = right;
+    char *k = left;
+    set(ctx, k, j);
+    k += size;
+    j += size;
+    n2--;
+    size_t min_gallop = state->min_gallop;
+    while (n1 > 1 && n2 > 0) {
+        // Merge one element at a time until one run wins consistently
+        size_t left_wins = 0;
+        size_t right_wins = 0;
+        while (n1 > 1 && n2 > 0 && left_wins < min_gallop && right_wins < min_gallop) {
+            if (compare_elements(ctx, j, i) < 0) {
+                set(ctx, k, j);
+                j += size;
+                n2--;
+                right_wins++;
+                left_wins = 0;
+            } else {
+                set(ctx, k, i);
+                i += size;
+                n1--;
+                left_wins++;
+                right_wins = 0;
+            }
+            k += size;
+        }
+        if (n1 <= 1 || n2 == 0) {
+            break;
+        }
+        // Gallop, moving whole blocks of elements, as long as it pays off
+        min_gallop++;
+        do {
+            min_gallop -= min_gallop > 1;
+            left_wins = tim_gallop(ctx, j, i, n1, 0, true);
+            count_moves(ctx, left_wins);
+            memcpy(k, i, left_wins * size);
+            k += left_wins * size;
+            i += left_wins * size;
+            n1 -= left_wins;
+            if (n1 <= 1) {
+                break;
+            }
+            set(ctx, k, j);
+            k += size;
+            j += size;
+            if (--n2 == 0) {
+                break;
+            }
+            right_wins = tim_gallop(ctx, i, j, n2, 0, false);
+            count_moves(ctx, right_wins);
+            memmove(k, j, right_wins * size);
+            k += right_wins * size;
+            j += right_wins * size;
+            n2 -= right_wins;
+            if (n2 == 0) {
+                break;
+            }
+            set(ctx, k, i);
+            k += size;
+            i += size;
+            n1--;
+        } while (n1 > 1 && (left_wins >= TIM_MIN_GALLOP || right_wins >= TIM_MIN_GALLOP));
+        min_gallop++;
+    }
+    state->min_gallop = min_gallop;
+    // The rest of the right run is already in place, move it before the rest of the left run
+    count_moves(ctx, n1 + n2);
+    memmove(k, j, n2 * size);
+    memcpy(k + n2 * size, i, n1 * size);
+}
+
+/**
+ * Merge two adjacent runs, when the right run is shorter than the left one. The right run is copied to the temporary
+ * array and the runs are merged from the end. The first element of the right run must be placed before the left run,
+ * and the last element of the left run must be placed after the right run.
+ *
+ * @param state The tim sort state.
+ * @param left The left run.
+ * @param n1 The number of elements in the left run.
+ * @param right The right run, which follows the left run.
+ * @param n2 The number of elements in the right run.
+ */
+static void tim_merge_high(TimSortState *state, char *left, size_t n1, char *right, size_t n2) {
+    const SortContext *ctx = state->ctx;
+    size_t size = ctx->size;
+    count_moves(ctx, n2);
+    memcpy(state->tmp, right, n2 * size);
+    char *i = left + (n1 - 1) * size;
+    char *j = state->tmp + (n2 - 1) * size;
+    char *k = right + (n2 - 1) * size;
+    set(ctx, k, i);
+    k -= size;
+    i -= size;
+    n1--;
+    size_t min_gallop = state->min_gallop;
+    while (n1 > 0 && n2 > 1) {
+        // Merge one element at a time until one run wins consistently
+        size_t left_wins = 0;
+        size_t right_wins = 0;
+        while (n1 > 0 && n2 > 1 && left_wins < min_gallop && right_wins < min_gallop) {
+            if (compare_elements(ctx, j, i) < 0) {
+                set(ctx, k, i);
+                i -= size;
+                n1--;
+                left_wins++;
+                right_wins = 0;
+            } else {
+                set(ctx, k, j);
+                j -= size;
+                n2--;
+                right_wins++;
+                left_wins = 0;
+            }
+            k -= size;
+        }
+        if (n1 == 0 || n2 <= 1) {
+            break;
+        }
+        // Gallop, moving whole blocks of elements, as long as it pays off
+        min_gallop++;
+        do {
+            min_gallop -= min_gallop > 1;
+            left_wins = n1 - tim_gallop(ctx, j, left, n1, n1 - 1, true);
+            k -= left_wins * size;
+            i -= left_wins * size;
+            count_moves(ctx, left_wins);
+            memmove(k + size, i + size, left_wins * size);
+            n1 -= left_wins;
+            if (n1 == 0) {
+                break;
+            }
+            set(ctx, k, j);
+            k -= size;
+            j -= size;
+            if (--n2 <= 1) {
+                break;
+            }
+            right_wins = n2 - tim_gallop(ctx, i, state->tmp, n2, n2 - 1, false);
+            k -= right_wins * size;
+            j -= right_wins * size;
+            count_moves(ctx, right_wins);
+            memcpy(k + size, j + size, right_wins * size);
+            n2 -= right_wins;
+            if (n2 <= 1) {
+                break;
+            }
+            set(ctx, k, i);
+            k -= size;
+            i -= size;
+            n1--;
+        } while (n1 > 0 && (left_wins >= TIM_MIN_GALLOP || right_wins >= TIM_MIN_GALLOP));
+        min_gallop++;
+    }
+    state->min_gallop = min_gallop;
+    // The rest of the right run is placed before the rest of the left run, which is already in place
+    count_moves(ctx, n1 + n2);
+    memmove(left + n2 * size, left, n1 * size);
+    memcpy(left, state->tmp, n2 * size);
+}
+
+/**
+ * Merge the pending run at the given position of the run stack with the run that follows it.
+ *
+ * @param state The tim sort state.
+ * @param index The position of the left run in the run stack.
+ */
+static void tim_merge_at(TimSortState *state, size_t index) {
+    const SortContext *ctx = state->ctx;
+    size_t size = ctx->size;
+    char *left = state->run_base[index];
+    size_t n1 = state->run_len[index];
+    char *right = state->run_base[index + 1];
+    size_t n2 = state->run_len[index + 1];
+    // Replace the two runs with the merged run
+    state->run_len[index] = n1 + n2;
+    if (index + 3 == state->nruns) {
+        state->run_base[index + 1] = state->run_base[index + 2];
+        state->run_len[index + 1] = state->run_len[index + 2];
+    }
+    state->nruns--;
+    // The elements of the left run that are placed before the right run are already in place
+    size_t skip = tim_gallop(ctx, right, left, n1, 0, true);
+    left += skip * size;
+    n1 -= skip;
+    if (n1 == 0) {
+        return;
+    }
+    // The elements of the right run that are placed after the left run are already in place
+    n2 = tim_gallop(ctx, left + (n1 - 1) * size, right, n2, n2 - 1, false);
+    if (n2 == 0) {
+        return;
+    }
+    if (n1 <= n2) {
+        tim_merge_low(state, left, n1, right, n2);
+    } else {
+        tim_merge_high(state, left, n1, right, n2);
+    }
+}
+
+/**
+ * Merge the pending runs until the lengths of the runs on the stack decrease faster than the Fibonacci numbers, so
+ * that merges stay balanced and the stack stays short.
+ *
+ * @param state The tim sort state.
+ */
+static void tim_merge_collapse(TimSortState *state) {
+    size_t *run_len = state->run_len;
+    while (state->nruns > 1) {
+        size_t n = state->nruns - 2;
+        if ((n > 0 && run_len[n - 1] <= run_len[n] + run_len[n + 1]) ||
+            (n > 1 && run_len[n - 2] <= run_len[n - 1] + run_len[n])) {
+            if (run_len[n - 1] < run_len[n + 1]) {
+                n--;
+            }
+        } else if (run_len[n] > run_len[n + 1]) {
+            break;
+        }
+        tim_merge_at(state, n);
+    }
+}
+
+/**
+ * Merge all the pending runs, until only one run is left.
+ *
+ * @param state The tim sort state.
+ */
+static void tim_merge_force_collapse(TimSortState *state) {
+    while (state->nruns > 1) {
+        size_t n = state->nruns - 2;
+        if (n > 0 && state->run_len[n - 1] < state->run_len[n + 1]) {
+            n--;
+        }
+        tim_merge_at(state, n);
+    }
+}
+
+/**
+ * Sort an array using tim sort.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ * @return true if the array was sorted, false if the temporary array could not be allocated.
+ */
+bool tim_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    if (n < 2) {
+        return true;
+    }
+    SortContext ctx;
+    sort_context_init(&ctx, size, compare);
+    TimSortState state;
+    state.ctx = &ctx;
+    state.min_gallop = TIM_MIN_GALLOP;
+    state.nruns = 0;
+    // Small arrays are sorted with binary insertion sort, and need no temporary array
+    state.tmp = NULL;
+    if (n >= TIM_MIN_MERGE) {
+        state.tmp = malloc(n / 2 * size);
+        if (!state.tmp) {
+            return false;
+        }
+        count_aux(&ctx, n / 2 * size);
+    }
+    // Find the runs, extend the short ones, and merge them as they are pushed to the stack
+    size_t min_run = tim_min_run(n);
+    char *low = base;
+    size_t remaining = n;
+    while (remaining > 0) {
+        size_t length = tim_count_run(&ctx, low, remaining);
+        if (length < min_run) {
+            size_t forced = remaining < min_run ? remaining : min_run;
+            tim_binary_insertion_sort(&ctx, low, forced, length);
+            length = forced;
+        }
+        state.run_base[state.nruns] = low;
+        state.run_len[state.nruns] = length;
+        state.nruns++;
+        tim_merge_collapse(&state);
+        low += length * size;
+        remaining -= length;
+    }
+    tim_merge_force_collapse(&state);
+    free(state.tmp);
+    // Assertion: The array must be sorted.
+    CHECK_SAMPLED(sorted(&ctx, base, n));
+
+    return true;
+}
+
+/**
+ * Load a 32-bit key and map it to an unsigned integer with the same order. Signed integers need the sign bit flipped,
+ * and floating point numbers additionally need all the other bits flipped when they are negative.
+ *
+ * @param element Pointer to the key.
+ * @param sign_mask The mask applied to all keys.
+ * @param neg_mask The mask applied additionally to keys that have the sign bit set.
+ * @return The unsigned key.
+ */
+static uint32_t radix_key_32(const void *element, uint32_t sign_mask, uint32_t neg_mask) {
+    uint32_t key;
+    memcpy(&key, element, sizeof(key));
+
+    return key ^ ((0u - (key >> 31)) & neg_mask) ^ sign_mask;
+}
+
+/**
+ * Load a 64-bit key and map it to an unsigned integer with the same order.
+ *
+ * @param element Pointer to the key.
+ * @param sign_mask The mask applied to all keys.
+ * @param neg_mask The mask applied additionally to keys that have the sign bit set.
+ * @return The unsigned key.
+ */
+static uint64_t radix_key_64(const void *element, uint64_t sign_mask, uint64_t neg_mask) {
+    uint64_t key;
+    memcpy(&key, element, sizeof(key));
+
+    return key ^ ((0u - (key >> 63)) & neg_mask) ^ sign_mask;
+}
+
+/**
+ * Convert the digit counts of a radix sort pass to the offsets where the elements of each digit start. If all the
+ * elements have the same digit, the pass can be skipped.
+ *
+ * @param counts The counts of each digit, which are replaced by the offsets.
+ * @param n The number of elements in the array.
+ * @return true if the pass is needed, false if it can be skipped.
+ */
+static bool radix_offsets(size_t *counts, size_t n) {
+    size_t offset = 0;
+    for (size_t digit = 0; digit < RADIX_BUCKETS; digit++) {
+        if (counts[digit] == n) {
+            return false;
+        }
+        size_t count = counts[digit];
+        counts[digit] = offset;
+        offset += count;
+    }
+
+    return true;
+}
+
+/**
+ * Sort an array of 32-bit keys using LSD radix sort, with 11-bit digits.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param sign_mask The mask applied to all keys to map them to unsigned integers.
+ * @param neg_mask The mask applied additionally to keys that have the sign bit set.
+ * @return true if the array was sorted, false if the auxiliary array could not be allocated.
+ */
+static bool radix_sort_32(void *base, size_t n, uint32_t sign_mask, uint32_t neg_mask) {
+    size_t size = sizeof(uint32_t);
+    size_t passes = (32 + RADIX_BITS - 1) / RADIX_BITS;
+    if (n <= SORT_NETWORK_MAX && neg_mask == 0) {
+        // Sort tiny integer arrays with a sorting network
+        if (sign_mask == 0) {
+            sort_network_u32(base, n);
+        } else {
+            sort_network_i32(base, n);
+        }
+        return true;
+    } else if (n < RADIX_CUTOFF) {
+        // Sort small arrays with insertion sort
+        for (size_t i = 1; i < n; i++) {
+            char element[sizeof(uint32_t)];
+            memcpy(element, (char *) base + i * size, size);
+            uint32_t key = radix_key_32(element, sign_mask, neg_mask);
+            size_t j = i;
+            for (; j > 0 && radix_key_32((char *) base + (j - 1) * size, sign_mask, neg_mask) > key; j--) {
+                memcpy((char *) base + j * size, (char *) base + (j - 1) * size, size);
+            }
+            memcpy((char *) base + j * size, element, size);
+        }
+        return true;
+    }
+
+    // Allocate the auxiliary array and the digit counts of all passes
+    void *aux = malloc(n * size);
+    size_t *counts = calloc(passes * RADIX_BUCKETS, sizeof(size_t));
+    if (!aux || !counts) {
+        free(aux);
+        free(counts);
+        return false;
+    }
+    // Count the digits of all passes at once
+    for (size_t i = 0; i < n; i++) {
+        uint32_t key = radix_key_32((char *) base + i * size, sign_mask, neg_mask);
+        for (size_t pass = 0; pass < passes; pass++) {
+            counts[pass * RADIX_BUCKETS + ((key >> (pass * RADIX_BITS)) & RADIX_MASK)]++;
+        }
+    }
+    // Distribute the elements by each digit, from the least significant to the most significant one
+    char *src = base;
+    char *dst = aux;
+    for (size_t pass = 0; pass < passes; pass++) {
+        size_t *offsets = counts + pass * RADIX_BUCKETS;
+        if (!radix_offsets(offsets, n)) {
+            continue;
+        }
+        for (size_t i = 0; i < n; i++) {
+            uint32_t key = radix_key_32(src + i * size, sign_mask, neg_mask);
+            memcpy(dst + offsets[(key >> (pass * RADIX_BITS)) & RADIX_MASK]++ * size, src + i * size, size);
+        }
+        char *temp = src;
+        src = dst;
+        dst = temp;
+    }
+    // Copy the result back if it ended up in the auxiliary array
+    if (src != base) {
+        memcpy(base, src, n * size);
+    }
+    free(aux);
+    free(counts);
+
+    return true;
+}
+
+/**
+ * Sort an array of 64-bit keys using LSD radix sort, with 11-bit digits.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param sign_mask The mask applied to all keys to map them to unsigned integers.
+ * @param neg_mask The mask applied additionally to keys that have the sign bit set.
+ * @return true if the array was sorted, false if the auxiliary array could not be allocated.
+ */
+static bool radix_sort_64(void *base, size_t n, uint64_t sign_mask, uint64_t neg_mask) {
+    size_t size = sizeof(uint64_t);
+    size_t passes = (64 + RADIX_BITS - 1) / RADIX_BITS;
+    if (n <= SORT_NETWORK_MAX && neg_mask == 0) {
+        // Sort tiny integer arrays with a sorting network
+        if (sign_mask == 0) {
+            sort_network_u64(base, n);
+        } else {
+            sort_network_i64(base, n);
+        }
+        return true;
+    } else if (n < RADIX_CUTOFF) {
+        // Sort small arrays with insertion sort
+        for (size_t i = 1; i < n; i++) {
+            char element[sizeof(uint64_t)];
+            memcpy(element, (char *) base + i * size, size);
+            uint64_t key = radix_key_64(element, sign_mask, neg_mask);
+            size_t j = i;
+            for (; j > 0 && radix_key_64((char *) base + (j - 1) * size, sign_mask, neg_mask) > key; j--) {
+                memcpy((char *) base + j * size, (char *) base + (j - 1) * size, size);
+            }
+            memcpy((char *) base + j * size, element, size);
+        }
+        return true;
+    }
+
+    // Allocate the auxiliary array and the digit counts of all passes
+    void *aux = malloc(n * size);
+    size_t *counts = calloc(passes * RADIX_BUCKETS, sizeof(size_t));
+    if (!aux || !counts) {
+        free(aux);
+        free(counts);
+        return false;
+    }
+    // Count the digits of all passes at once
+    for (size_t i = 0; i < n; i++) {
+        uint64_t key = radix_key_64((char *) base + i * size, sign_mask, neg_mask);
+        for (size_t pass = 0; pass < passes; pass++) {
+            counts[pass * RADIX_BUCKETS + ((key >> (pass * RADIX_BITS)) & RADIX_MASK)]++;
+        }
+    }
+    // Distribute the elements by each digit, from the least significant to the most significant one
+    char *src = base;
+    char *dst = aux;
+    for (size_t pass = 0; pass < passes; pass++) {
+        size_t *offsets = counts + pass * RADIX_BUCKETS;
+        if (!radix_offsets(offsets, n)) {
+            continue;
+        }
+        for (size_t i = 0; i < n; i++) {
+            uint64_t key = radix_key_64(src + i * size, sign_mask, neg_mask);
+            memcpy(dst + offsets[(key >> (pass * RADIX_BITS)) & RADIX_MASK]++ * size, src + i * size, size);
+        }
+        char *temp = src;
+        src = dst;
+        dst = temp;
+    }
+    // Copy the result back if it ended up in the auxiliary array
+    if (src != base) {
+        memcpy(base, src, n * size);
+    }
+    free(aux);
+    free(counts);
+
+    return true;
+}
+
+/**
+ * Sort an array of unsigned 32-bit integers using LSD radix sort.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @return true if the array was sorted, false if the auxiliary array could not be allocated.
+ */
+bool radix_sort_u32(uint32_t *base, size_t n) {
+    return radix_sort_32(base, n, 0, 0);
+}
+
+/**
+ * Sort an array of signed 32-bit integers using LSD radix sort.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @return true if the array was sorted, false if the auxiliary array could not be allocated.
+ */
+bool radix_sort_i32(int32_t *base, size_t n) {
+    return radix_sort_32(base, n, UINT32_C(1) << 31, 0);
+}
+
+/**
+ * Sort an array of unsigned 64-bit integers using LSD radix sort.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @return true if the array was sorted, false if the auxiliary array could not be allocated.
+ */
+bool radix_sort_u64(uint64_t *base, size_t n) {
+    return radix_sort_64(base, n, 0, 0);
+}
+
+/**
+ * Sort an array of signed 64-bit integers using LSD radix sort.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @return true if the array was sorted, false if the auxiliary array could not be allocated.
+ */
+bool radix_sort_i64(int64_t *base, size_t n) {
+    return radix_sort_64(base, n, UINT64_C(1) << 63, 0);
+}
+
+/**
+ * Sort an array of floats using LSD radix sort.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @return true if the array was sorted, false if the auxiliary array could not be allocated.
+ */
+bool radix_sort_f32(float *base, size_t n) {
+    return radix_sort_32(base, n, UINT32_C(1) << 31, ~(UINT32_C(1) << 31));
+}
+
+/**
+ * Sort an array of doubles using LSD radix sort.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @return true if the array was sorted, false if the auxiliary array could not be allocated.
+ */
+bool radix_sort_f64(double *base, size_t n) {
+    return radix_sort_64(base, n, UINT64_C(1) << 63, ~(UINT64_C(1) << 63));
+}
+
+/**
+ * Sort an array of elements with embedded keys using LSD radix sort, with 11-bit digits.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param key Pointer to a function that returns the key of an element.
+ * @return true if the array was sorted, false if the auxiliary array could not be allocated.
+ */
+bool radix_sort_key(void *base, size_t n, size_t size, KEY_FUNC key) {
+    SortContext ctx;
+    sort_context_init(&ctx, size, NULL);
+    size_t passes = (64 + RADIX_BITS - 1) / RADIX_BITS;
+    if (n < RADIX_CUTOFF) {
+        // Sort small arrays with insertion sort
+        char element[size];
+        for (size_t i = 1; i < n; i++) {
+            set(&ctx, element, (char *) base + i * size);
+            uint64_t element_key = key(element);
+            size_t j = i;
+            for (; j > 0 && key((char *) base + (j - 1) * size) > element_key; j--) {
+                set(&ctx, (char *) base + j * size, (char *) base + (j - 1) * size);
+            }
+            set(&ctx, (char *) base + j * size, element);
+        }
+        return true;
+    }
+
+    // Allocate the auxiliary array and the digit counts of all passes
+    void *aux = malloc(n * size);
+    size_t *counts = calloc(passes * RADIX_BUCKETS, sizeof(size_t));
+    if (!aux || !counts) {
+        free(aux);
+        free(counts);
+        return false;
+    }
+    count_aux(&ctx, n * size + passes * RADIX_BUCKETS * sizeof(size_t));
+    // Count the digits of all passes at once
+    for (size_t i = 0; i < n; i++) {
+        uint64_t element_key = key((char *) base + i * size);
+        for (size_t pass = 0; pass < passes; pass++) {
+            counts[pass * RADIX_BUCKETS + ((element_key >> (pass * RADIX_BITS)) & RADIX_MASK)]++;
+        }
+    }
+    // Distribute the elements by each digit, from the least significant to the most significant one
+    char *src = base;
+    char *dst = aux;
+    for (size_t pass = 0; pass < passes; pass++) {
+        size_t *offsets = counts + pass * RADIX_BUCKETS;
+        if (!radix_offsets(offsets, n)) {
+            continue;
+        }
+        for (size_t i = 0; i < n; i++) {
+            uint64_t element_key = key(src + i * size);
+            set(&ctx, dst + offsets[(element_key >> (pass * RADIX_BITS)) & RADIX_MASK]++ * size, src + i * size);
+        }
+        char *temp = src;
+        src = dst;
+        dst = temp;
+    }
+    // Copy the result back if it ended up in the auxiliary array
+    if (src != base) {
+        count_moves(&ctx, n);
+        memcpy(base, src, n * size);
+    }
+    free(aux);
+    free(counts);
+
+    return true;
+}
+
+/**
+ * Return the digit of a key that an American flag sort pass sorts by.
+ *
+ * @param key The key.
+ * @param shift The position of the lowest bit of the digit.
+ * @return The digit.
+ */
+static size_t american_flag_digit(uint64_t key, unsigned shift) {
+    return (size_t) (key >> shift) & (AMERICAN_FLAG_BUCKETS - 1);
+}
+
+/**
+ * Move the elements of an array to their buckets by following permutation cycles. Each element taken out of place is
+ * written to the next free position of its bucket, and the element found there is moved next, until an element that
+ * belongs to the starting bucket is found.
+ *
+ * @param base A pointer to the first element of the array.
+ * @param heads The index of the first element of each bucket that is not yet in place. Updated as elements are placed.
+ * @param tails The index after the last element of each bucket.
+ * @param shift The position of the lowest bit of the digit.
+ */
+static void american_flag_permute(uint64_t *base, size_t *heads, const size_t *tails, unsigned shift) {
+    for (size_t bucket = 0; bucket < AMERICAN_FLAG_BUCKETS; bucket++) {
+        while (heads[bucket] < tails[bucket]) {
+            uint64_t key = base[heads[bucket]];
+            size_t digit = american_flag_digit(key, shift);
+            while (digit != bucket) {
+                uint64_t temp = base[heads[digit]];
+                base[heads[digit]++] = key;
+                key = temp;
+                digit = american_flag_digit(key, shift);
+            }
+            base[heads[bucket]++] = key;
+        }
+    }
+}
+
+/**
+ * Implement the American flag sort on the array, starting from the digit at the given shift.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param shift The position of the lowest bit of the most significant digit that is not yet sorted.
+ */
+static void american_flag_sort_impl(uint64_t *base, size_t n, unsigned shift) {
+    if (n <= SORT_NETWORK_MAX) {
+        // Sort tiny buckets with a sorting network
+        sort_network_u64(base, n);
+        return;
+    } else if (n < RADIX_CUTOFF) {
+        // Sort small arrays with insertion sort
+        for (size_t i = 1; i < n; i++) {
+            uint64_t key = base[i];
+            size_t j = i;
+            for (; j > 0 && base[j - 1] > key; j--) {
+                base[j] = base[j - 1];
+            }
+            base[j] = key;
+        }
+        return;
+    }
+    // Count the digits, skipping the digits that are the same for all the keys
+    size_t counts[AMERICAN_FLAG_BUCKETS];
+    for (;;) {
+        memset(counts, 0, sizeof(counts));
+        for (size_t i = 0; i < n; i++) {
+            counts[american_flag_digit(base[i], shift)]++;
+        }
+        if (counts[american_flag_digit(base[0], shift)] < n) {
+            break;
+        }
+        if (shift == 0) {
+            return;
+        }
+        shift -= AMERICAN_FLAG_BITS;
+    }
+    // Move the elements to their buckets
+    size_t heads[AMERICAN_FLAG_BUCKETS];
+    size_t tails[AMERICAN_FLAG_BUCKETS];
+    size_t offset = 0;
+    for (size_t bucket = 0; bucket < AMERICAN_FLAG_BUCKETS; bucket++) {
+        heads[bucket] = offset;
+        offset += counts[bucket];
+        tails[bucket] = offset;
+    }
+    american_flag_permute(base, heads, tails, shift);
+    // Sort each bucket by the next digit
+    if (shift == 0) {
+        return;
+    }
+    for (size_t bucket = 0; bucket < AMERICAN_FLAG_BUCKETS; bucket++) {
+        if (counts[bucket] > 1) {
+            american_flag_sort_impl(base + tails[bucket] - counts[bucket], counts[bucket], shift - AMERICAN_FLAG_BITS);
+        }
+    }
+}
+
+/**
+ * Sort an array of unsigned 64-bit integers in place using American flag sort.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ */
+void american_flag_sort_u64(uint64_t *base, size_t n) {
+    american_flag_sort_impl(base, n, 64 - AMERICAN_FLAG_BITS);
+}
+
+/**
+ * A pass of the parallel American flag sort over one digit.
+ */
+typedef struct AmericanFlagPass AmericanFlagPass;
+
+/**
+ * A worker thread of the parallel American flag sort. The worker counts and permutes a stripe of each bucket, and then
+ * repairs and recursively sorts a contiguous range of buckets.
+ */
+typedef struct {
+    /** The pass that the worker belongs to. */
+    AmericanFlagPass *pass;
+    /** The index of the worker. */
+    size_t index;
+    /** The first bucket assigned to the worker. */
+    size_t first_bucket;
+    /** The bucket after the last bucket assigned to the worker. */
+    size_t last_bucket;
+    /** The index of the first element of the stripe of each bucket that is not yet in place. */
+    size_t heads[AMERICAN_FLAG_BUCKETS];
+    /** The index after the last element of the stripe of each bucket. */
+    size_t tails[AMERICAN_FLAG_BUCKETS];
+} AmericanFlagWorker;
+
+struct AmericanFlagPass {
+    /** The array to be sorted. */
+    uint64_t *base;
+    /** The number of elements in the array. */
+    size_t n;
+    /** The position of the lowest bit of the digit. */
+    unsigned shift;
+    /** The workers. */
+    AmericanFlagWorker *workers;
+    /** The number of workers. */
+    size_t nthreads;
+    /** The number of elements in each bucket. */
+    size_t counts[AMERICAN_FLAG_BUCKETS];
+    /** The index of the first element of each bucket that is not yet in place. */
+    size_t heads[AMERICAN_FLAG_BUCKETS];
+    /** The index after the last element of each bucket. */
+    size_t tails[AMERICAN_FLAG_BUCKETS];
+};
+
+/**
+ * Count the digits of the stripe of the array that belongs to a worker. The counts are stored in the heads of the
+ * worker.
+ *
+ * @param arg Pointer to the worker.
+ * @return NULL.
+ */
+static void *american_flag_count(void *arg) {
+    AmericanFlagWorker *worker = arg;
+    const AmericanFlagPass *pass = worker->pass;
+    size_t begin = pass->n * worker->index / pass->nthreads;
+    size_t end = pass->n * (worker->index + 1) / pass->nthreads;
+    memset(worker->heads, 0, sizeof(worker->heads));
+    for (size_t i = begin; i < end; i++) {
+        worker->heads[american_flag_digit(pass->base[i], pass->shift)]++;
+    }
+
+    return NULL;
+}
+
+/**
+ * Move the elements of the stripes of a worker to their buckets, as far as the stripes of the worker allow. Elements
+ * are swapped into the stripes of their bucket until the stripe is full, so that the first part of each stripe holds
+ * the elements that are in place. The rest of each stripe is left for the repair phase.
+ *
+ * @param arg Pointer to the worker.
+ * @return NULL.
+ */
+static void *american_flag_speculate(void *arg) {
+    AmericanFlagWorker *worker = arg;
+    const AmericanFlagPass *pass = worker->pass;
+    uint64_t *base = pass->base;
+    size_t *heads = worker->heads;
+    const size_t *tails = worker->tails;
+    for (size_t bucket = 0; bucket < AMERICAN_FLAG_BUCKETS; bucket++) {
+        while (heads[bucket] < tails[bucket]) {
+            size_t digit = american_flag_digit(base[heads[bucket]], pass->shift);
+            if (digit == bucket) {
+                heads[bucket]++;
+            } else if (heads[digit] < tails[digit]) {
+                uint64_t temp = base[heads[digit]];
+                base[heads[digit]++] = base[heads[bucket]];
+                base[heads[bucket]] = temp;
+            } else {
+                // The stripe of the bucket of the element is full
+                break;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Move the elements that are in place to the start of each bucket assigned to a worker, and advance the head of the
+ * bucket past them.
+ *
+ * @param arg Pointer to the worker.
+ * @return NULL.
+ */
+static void *american_flag_repair(void *arg) {
+    AmericanFlagWorker *worker = arg;
+    AmericanFlagPass *pass = worker->pass;
+    uint64_t *base = pass->base;
+    for (size_t bucket = worker->first_bucket; bucket < worker->last_bucket; bucket++) {
+        size_t i = pass->heads[bucket];
+        size_t j = pass->tails[bucket];
+        for (;;) {
+            while (i < j && american_flag_digit(base[i], pass->shift) == bucket) {
+                i++;
+            }
+            while (i < j && american_flag_digit(base[j - 1], pass->shift) != bucket) {
+                j--;
+            }
+            if (i == j) {
+                break;
+            }
+            uint64_t temp = base[i];
+            base[i] = base[j - 1];
+            base[j - 1] = temp;
+        }
+        pass->heads[bucket] = i;
+    }
+
+    return NULL;
+}
+
+/**
+ * Sort the buckets assigned to a worker by the next digit.
+ *
+ * @param arg Pointer to the worker.
+ * @return NULL.
+ */
+static void *american_flag_recurse(void *arg) {
+    AmericanFlagWorker *worker = arg;
+    const AmericanFlagPass *pass = worker->pass;
+    for (size_t bucket = worker->first_bucket; bucket < worker->last_bucket; bucket++) {
+        size_t count = pass->counts[bucket];
+        if (count > 1 && count <= pass->n / pass->nthreads) {
+            american_flag_sort_impl(pass->base + pass->tails[bucket] - count, count,
+                                    pass->shift - AMERICAN_FLAG_BITS);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Assign contiguous ranges of buckets to the workers, so that each worker gets about the same total weight.
+ *
+ * @param workers The workers.
+ * @param nthreads The number of workers.
+ * @param weights The weight of each bucket.
+ */
+static void american_flag_assign(AmericanFlagWorker *workers, size_t nthreads, const size_t *weights) {
+    size_t total = 0;
+    for (size_t bucket = 0; bucket < AMERICAN_FLAG_BUCKETS; bucket++) {
+        total += weights[bucket];
+    }
+    size_t bucket = 0;
+    size_t weight = 0;
+    for (size_t i = 0; i < nthreads; i++) {
+        workers[i].first_bucket = bucket;
+        while (bucket < AMERICAN_FLAG_BUCKETS && (i == nthreads - 1 || weight < total / nthreads * (i + 1))) {
+            weight += weights[bucket++];
+        }
+        workers[i].last_bucket = bucket;
+    }
+}
+
+/**
+ * Implement the American flag sort on the array using multiple threads. Each pass counts the digits in parallel, and
+ * then moves the elements to their buckets in rounds. In each round, every worker permutes its own stripe of each
+ * bucket, and the elements that could not be placed are gathered at the end of their bucket for the next round. If a
+ * round places less than half of the remaining elements, the rest are placed by a single thread. The buckets are then
+ * sorted in parallel, with the large buckets sorted by all the workers in turn.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param shift The position of the lowest bit of the most significant digit that is not yet sorted.
+ * @param workers The workers.
+ * @param nthreads The number of workers.
+ */
+static void parallel_american_flag_sort_impl(uint64_t *base, size_t n, unsigned shift, AmericanFlagWorker *workers,
+                                             size_t nthreads) {
+    if (n < PARALLEL_CUTOFF * nthreads) {
+        american_flag_sort_impl(base, n, shift);
+        return;
+    }
+    AmericanFlagPass pass = {base, n, shift, workers, nthreads, {0}, {0}, {0}};
+    for (size_t i = 0; i < nthreads; i++) {
+        workers[i].pass = &pass;
+        workers[i].index = i;
+    }
+    // Count the digits, skipping the digits that are the same for all the keys
+    for (;;) {
+        run_parallel(american_flag_count, workers, nthreads, sizeof(AmericanFlagWorker));
+        memset(pass.counts, 0, sizeof(pass.counts));
+        for (size_t i = 0; i < nthreads; i++) {
+            for (size_t bucket = 0; bucket < AMERICAN_FLAG_BUCKETS; bucket++) {
+                pass.counts[bucket] += workers[i].heads[bucket];
+            }
+        }
+        if (pass.counts[american_flag_digit(base[0], pass.shift)] < n) {
+            break;
+        }
+        if (pass.shift == 0) {
+            return;
+        }
+        pass.shift -= AMERICAN_FLAG_BITS;
+    }
+    size_t offset = 0;
+    for (size_t bucket = 0; bucket < AMERICAN_FLAG_BUCKETS; bucket++) {
+        pass.heads[bucket] = offset;
+        offset += pass.counts[bucket];
+        pass.tails[bucket] = offset;
+    }
+    // Move the elements to their buckets in rounds
+    size_t remaining = n;
+    while (remaining > 0) {
+        // Split the rest of each bucket into one stripe per worker
+        for (size_t i = 0; i < nthreads; i++) {
+            for (size_t bucket = 0; bucket < AMERICAN_FLAG_BUCKETS; bucket++) {
+                size_t length = pass.tails[bucket] - pass.heads[bucket];
+                workers[i].heads[bucket] = pass.heads[bucket] + length * i / nthreads;
+                workers[i].tails[bucket] = pass.heads[bucket] + length * (i + 1) / nthreads;
+            }
+        }
+        run_parallel(american_flag_speculate, workers, nthreads, sizeof(AmericanFlagWorker));
+        // Gather the elements that are not yet in place at the end of their bucket
+        size_t lengths[AMERICAN_FLAG_BUCKETS];
+        for (size_t bucket = 0; bucket < AMERICAN_FLAG_BUCKETS; bucket++) {
+            lengths[bucket] = pass.tails[bucket] - pass.heads[bucket];
+        }
+        american_flag_assign(workers, nthreads, lengths);
+        run_parallel(american_flag_repair, workers, nthreads, sizeof(AmericanFlagWorker));
+        size_t left = 0;
+        for (size_t bucket = 0; bucket < AMERICAN_FLAG_BUCKETS; bucket++) {
+            left += pass.tails[bucket] - pass.heads[bucket];
+        }
+        if (left > remaining / 2) {
+            american_flag_permute(base, pass.heads, pass.tails, pass.shift);
+            break;
+        }
+        remaining = left;
+    }
+    // Sort each bucket by the next digit
+    if (pass.shift == 0) {
+        return;
+    }
+    american_flag_assign(workers, nthreads, pass.counts);
+    run_parallel(american_flag_recurse, workers, nthreads, sizeof(AmericanFlagWorker));
+    for (size_t bucket = 0; bucket < AMERICAN_FLAG_BUCKETS; bucket++) {
+        if (pass.counts[bucket] > n / nthreads) {
+            parallel_american_flag_sort_impl(base + pass.tails[bucket] - pass.counts[bucket], pass.counts[bucket],
+                                             pass.shift - AMERICAN_FLAG_BITS, workers, nthreads);
+        }
+    }
+}
+
+/**
+ * Sort an array of unsigned 64-bit integers in place using American flag sort with multiple threads.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param nthreads The number of threads to use, or zero to use one thread per online processor.
+ */
+void parallel_american_flag_sort_u64(uint64_t *base, size_t n, size_t nthreads) {
+    nthreads = sort_threads(nthreads, n);
+    AmericanFlagWorker *workers = nthreads > 1 ? malloc(nthreads * sizeof(AmericanFlagWorker)) : NULL;
+    if (!workers) {
+        // Sort with a single thread
+        american_flag_sort_impl(base, n, 64 - AMERICAN_FLAG_BITS);
+        return;
+    }
+    parallel_american_flag_sort_impl(base, n, 64 - AMERICAN_FLAG_BITS, workers, nthreads);
+    free(workers);
+}
+
+/**
+ * An element of the array that the key-prefix arg sort sorts: the key prefix of an array element and its index.
+ */
+typedef struct {
+    // The key prefix of the element
+    uint64_t prefix;
+    // The index of the element
+    size_t index;
+} ArgSortPair;
+
+/**
+ * Check if the provided permutation sorts the array.
+ *
+ * @param ctx The sort context.
+ * @param perm The permutation, as an array of the indexes of the array elements.
+ * @param base A pointer to the first element of the array.
+ * @param n The number of elements in the array pointed by base.
+ */
+static bool arg_sorted(const SortContext *ctx, const size_t *perm, const void *base, size_t n) {
+    size_t size = ctx->size;
+    for (size_t i = 1; i < n; i++) {
+        if (ctx->compare((const char *) base + perm[i - 1] * size, (const char *) base + perm[i] * size) > 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Compare two array elements given their indexes.
+ *
+ * @param ctx The sort context.
+ * @param base A pointer to the first element of the array.
+ * @param i The index of the first element.
+ * @param j The index of the second element.
+ * @return The result of the comparison of the elements.
+ */
+static int arg_compare(const SortContext *ctx, const void *base, size_t i, size_t j) {
+    return compare_elements(ctx, (const char *) base + i * ctx->size, (const char *) base + j * ctx->size);
+}
+
+/**
+ * Implement merge sort on an array of element indexes, using the auxiliary array for storage.
+ *
+ * @param ctx The sort context.
+ * @param perm The array of element indexes to be sorted.
+ * @param aux The auxiliary array, with room for n / 2 indexes.
+ * @param base A pointer to the first element of the array that the indexes refer to.
+ * @param n The number of indexes.
+ */
+static void arg_sort_impl(const SortContext *ctx, size_t *perm, size_t *aux, const void *base, size_t n) {
+    // For small arrays, cutoff to insertion sort
+    if (n < CUTOFF) {
+        for (size_t i = 1; i < n; i++) {
+            size_t index = perm[i];
+            size_t j = i;
+            for (; j > 0 && arg_compare(ctx, base, index, perm[j - 1]) < 0; j--) {
+                perm[j] = perm[j - 1];
+            }
+            perm[j] = index;
+        }
+        return;
+    }
+    // Sort the two halves
+    size_t mid = n / 2;
+    count_enter(ctx);
+    arg_sort_impl(ctx, perm, aux, base, mid);
+    arg_sort_impl(ctx, perm + mid, aux, base, n - mid);
+    count_leave(ctx, 1);
+    if (arg_compare(ctx, base, perm[mid], perm[mid - 1]) >= 0) {
+        return;
+    }
+    // Merge the halves. Only the left half is copied, the right half is merged in place.
+    memcpy(aux, perm, mid * sizeof(size_t));
+    size_t i = 0;
+    size_t j = mid;
+    size_t k = 0;
+    while (i < mid && j < n) {
+        if (arg_compare(ctx, base, perm[j], aux[i]) < 0) {
+            perm[k++] = perm[j++];
+        } else {
+            perm[k++] = aux[i++];
+        }
+    }
+    memcpy(perm + k, aux + i, (mid - i) * sizeof(size_t));
+}
+
+/**
+ * Sort an array indirectly: find the permutation of the array element indexes that sorts the array.
+ *
+ * @param perm The array where the permutation is stored, with room for n indexes.
+ * @param base A pointer to the first element of the array.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ * @return true if the permutation was found, false if the auxiliary array could not be allocated.
+ */
+bool arg_sort(size_t *perm, const void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    SortContext ctx;
+    sort_context_init(&ctx, size, compare);
+    size_t *aux = malloc((n / 2 + 1) * sizeof(size_t));
+    if (!aux) {
+        return false;
+    }
+    count_aux(&ctx, (n / 2 + 1) * sizeof(size_t));
+    for (size_t i = 0; i < n; i++) {
+        perm[i] = i;
+    }
+    arg_sort_impl(&ctx, perm, aux, base, n);
+    free(aux);
+    // Assertion: The permutation must sort the array.
+    CHECK_SAMPLED(arg_sorted(&ctx, perm, base, n));
+
+    return true;
+}
+
+/**
+ * Returns the radix sort key of a key-prefix arg sort element, which is the key prefix.
+ *
+ * @param item Pointer to the element.
+ * @return The key prefix.
+ */
+static uint64_t arg_sort_pair_key(const void *item) {
+    return ((const ArgSortPair *) item)->prefix;
+}
+
+/**
+ * Sort an array indirectly, comparing the key prefixes of the elements first.
+ *
+ * @param perm The array where the permutation is stored, with room for n indexes.
+ * @param base A pointer to the first element of the array.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ * @param prefix Pointer to a function that returns the key prefix of an element.
+ * @return true if the permutation was found, false if the auxiliary arrays could not be allocated.
+ */
+bool arg_sort_prefix(size_t *perm, const void *base, size_t n, size_t size, COMPARE_FUNC compare, KEY_FUNC prefix) {
+    if (n < 2) {
+        // Nothing to sort, and no arrays to allocate
+        if (n == 1) {
+            perm[0] = 0;
+        }
+        return true;
+    }
+    SortContext ctx;
+    sort_context_init(&ctx, size, compare);
+    ArgSortPair *pairs = malloc(n * sizeof(ArgSortPair));
+    size_t *aux = malloc((n / 2 + 1) * sizeof(size_t));
+    if (!pairs || !aux) {
+        free(pairs);
+        free(aux);
+        return false;
+    }
+    count_aux(&ctx, n * sizeof(ArgSortPair) + (n / 2 + 1) * sizeof(size_t));
+    // Sort the prefixes with radix sort, which keeps the elements with equal prefixes in index order
+    for (size_t i = 0; i < n; i++) {
+        pairs[i].prefix = prefix((const char *) base + i * size);
+        pairs[i].index = i;
+    }
+    if (!radix_sort_key(pairs, n, sizeof(ArgSortPair), arg_sort_pair_key)) {
+        free(pairs);
+        free(aux);
+        return false;
+    }
+    // Sort the runs of equal prefixes with the comparison function
+    size_t start = 0;
+    for (size_t i = 0; i < n; i++) {
+        perm[i] = pairs[i].index;
+        if (i + 1 == n || pairs[i + 1].prefix != pairs[i].prefix) {
+            if (i > start) {
+                arg_sort_impl(&ctx, perm + start, aux, base, i - start + 1);
+            }
+            start = i + 1;
+        }
+    }
+    free(pairs);
+    free(aux);
+    // Assertion: The permutation must sort the array.
+    CHECK_SAMPLED(arg_sorted(&ctx, perm, base, n));
+
+    return true;
+}
+
+/**
+ * Reorder an array by a permutation, so that the element at position i is the element that was at position perm[i].
+ *
+ * @param base A pointer to the first element of the array.
+ * @param perm The permutation, as an array of the indexes of the array elements.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ */
+void apply_permutation(void *base, size_t *perm, size_t n, size_t size) {
+    SortContext ctx;
+    sort_context_init(&ctx, size, NULL);
+    char element[size];
+    // Follow each cycle of the permutation, moving each element once. The visited positions are marked by
+    // complementing their index, which is restored at the end.
+    for (size_t i = 0; i < n; i++) {
+        if (perm[i] >= n) {
+            continue;
+        }
+        set(&ctx, element, (char *) base + i * size);
+        size_t j = i;
+        while (perm[j] != i) {
+            size_t next = perm[j];
+            set(&ctx, (char *) base + j * size, (char *) base + next * size);
+            perm[j] = ~next;
+            j = next;
+        }
+        set(&ctx, (char *) base + j * size, element);
+        perm[j] = ~i;
+    }
+    for (size_t i = 0; i < n; i++) {
+        perm[i] = ~perm[i];
+    }
+}
@@ -0,0 +1,12 @@
+#include "typed_sort.h"
+#include "sort_network.h"
+
+DEFINE_SORT_WITH_KERNELS(int, int, a < b, sort_network_i32, sort_network_merge_i32)
+
+DEFINE_SORT(long, long, a < b)
+
+DEFINE_SORT(double, double, a < b)
+
+DEFINE_SORT_WITH_KERNELS(uint64, uint64_t, a < b, sort_network_u64, sort_network_merge_u64)
+
+DEFINE_SORT(string, const char *, strcmp(a, b) < 0)
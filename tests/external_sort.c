@@ -0,0 +1,190 @@
+/**
+ * Test program for external sorting.
+ */
+#include "external_sort.h"
+
+#include <getopt.h>
+#include <sys/time.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Returns the number of seconds since the UNIX epoch.
+ *
+ * @return The number of seconds since the UNIX epoch.
+ */
+static double get_time(void) {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+
+    return t.tv_sec + t.tv_usec * 1e-6;
+}
+
+/**
+ * Compares two records by their integer key.
+ *
+ * @param first The first record.
+ * @param second The second record.
+ * @return 1 if the first key is greater that the second, -1 if the first is less than the second, and 0 if they are
+ * equal.
+ */
+static int compare_int(const void *first, const void *second) {
+    int ifirst;
+    int isecond;
+    memcpy(&ifirst, first, sizeof(int));
+    memcpy(&isecond, second, sizeof(int));
+    if (ifirst > isecond) {
+        return 1;
+    } else if (ifirst < isecond) {
+        return -1;
+    } else {
+        return 0;
+    }
+}
+
+/**
+ * Returns the FNV-1a hash of a record.
+ *
+ * @param record The record.
+ * @param size The size in bytes of the record.
+ * @return The hash of the record.
+ */
+static uint64_t hash_record(const char *record, size_t size) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ (unsigned char) record[i]) * 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/**
+ * Write a file of records with random integer keys. The rest of each record is padding.
+ *
+ * @param fp The file to write to.
+ * @param n The number of records.
+ * @param size The size in bytes of each record.
+ * @param checksum Set to the sum of the hashes of the records, which does not depend on their order.
+ * @return true if the file was written, false otherwise.
+ */
+static bool write_random(FILE *fp, size_t n, size_t size, uint64_t *checksum) {
+    char record[size];
+    memset(record, 0, size);
+    *checksum = 0;
+    for (size_t i = 0; i < n; i++) {
+        int key = rand();
+        memcpy(record, &key, sizeof(int));
+        if (fwrite(record, size, 1, fp) != 1) {
+            return false;
+        }
+        *checksum += hash_record(record, size);
+    }
+
+    return true;
+}
+
+/**
+ * Check that a file holds the expected number of records, in sorted order, and that they are a permutation of the
+ * written records, by the sum of their hashes.
+ *
+ * @param fp The file to check.
+ * @param n The expected number of records.
+ * @param size The size in bytes of each record.
+ * @param checksum The sum of the hashes of the written records.
+ * @return true if the file is sorted, false otherwise.
+ */
+static bool check_sorted(FILE *fp, size_t n, size_t size, uint64_t checksum) {
+    char previous[size];
+    char record[size];
+    size_t count = 0;
+    uint64_t sum = 0;
+    while (fread(record, size, 1, fp) == 1) {
+        if (count > 0 && compare_int(previous, record) > 0) {
+            return false;
+        }
+        memcpy(previous, record, size);
+        sum += hash_record(record, size);
+        count++;
+    }
+
+    return count == n && sum == checksum;
+}
+
+int main(int argc, char **argv) {
+    static struct option long_options[] = {
+        {"num", required_argument, 0, 'n'},
+        {"element-size", required_argument, 0, 's'},
+        {"memory", required_argument, 0, 'm'},
+        {0, 0, 0, 0}
+    };
+    int option_index = 0;
+    int c;
+    size_t num_elements = 0;
+    size_t element_size = sizeof(int);
+    ExternalSortOptions options = {0, NULL, NULL};
+    while ((c = getopt_long(argc, argv, "n:s:m:", long_options, &option_index)) != -1) {
+        switch(c) {
+            case 'n':
+                num_elements = (size_t) atol(optarg);
+                break;
+            case 's':
+                element_size = (size_t) atoi(optarg);
+                if (element_size < sizeof(int)) {
+                    fprintf(stderr, "The element size must be at least %zu.\n", sizeof(int));
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'm':
+                options.memory = (size_t) atol(optarg);
+                break;
+            default:
+                fprintf(stderr, "Invalid option: %c\n", c);
+                return EXIT_FAILURE;
+        }
+    }
+
+    // Write the random records to a temporary file
+    srand(time(NULL));
+    char path[] = "/tmp/external-sort-test-XXXXXX";
+    int fd = mkstemp(path);
+    FILE *fp = fd >= 0 ? fdopen(fd, "w") : NULL;
+    if (!fp) {
+        fprintf(stderr, "Cannot create the temporary file.\n");
+        return EXIT_FAILURE;
+    }
+    uint64_t checksum;
+    bool written = write_random(fp, num_elements, element_size, &checksum);
+    if (fclose(fp) != 0 || !written) {
+        fprintf(stderr, "Cannot write the temporary file.\n");
+        unlink(path);
+        return EXIT_FAILURE;
+    }
+
+    // Sort the file in place and print the running time
+    printf("Testing external sort for random file of %zu records with %zu bytes\n", num_elements, element_size);
+    double start = get_time();
+    bool sorted = external_sort_path(path, path, element_size, compare_int, &options);
+    double end = get_time();
+    if (!sorted) {
+        perror("Cannot sort the file");
+        unlink(path);
+        return EXIT_FAILURE;
+    }
+    printf("Total time: %.3f\n", end - start);
+
+    // Check the result
+    fp = fopen(path, "r");
+    bool ok = fp && check_sorted(fp, num_elements, element_size, checksum);
+    if (fp) {
+        fclose(fp);
+    }
+    unlink(path);
+    printf("%s\n", ok ? "The file is sorted" : "The file is not sorted");
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
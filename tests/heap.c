@@ -1,8 +1,71 @@
+/**
+ * Test program for the heap implementations.
+ */
+#include "bheap.h"
+#include "dheap.h"
+#include "iheap.h"
+#include "kheap.h"
+#include "pheap.h"
+#include "rheap.h"
+
+#include <getopt.h>
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#include "bheap.h"
+/**
+ * A pairing heap that keeps the node of each handle, so that the items can be decreased by their handles, and a second
+ * pairing heap whose items are melded to it.
+ */
+typedef struct {
+    // The heap
+    PHeap ph;
+    // The heap whose items are melded to the heap
+    PHeap other;
+    // The node of each handle, or NULL if no item has the handle
+    PHeapNode **nodes;
+    // Whether the item of each handle is in the other heap
+    bool *in_other;
+    // The number of handles
+    size_t capacity;
+} PairingHeap;
+
+/**
+ * The heap data structures that are tested.
+ */
+typedef union {
+    BHeap bh;
+    DHeap dh;
+    IHeap ih;
+    KHeap kh;
+    PairingHeap ph;
+    RHeap rh;
+} Heap;
+
+/**
+ * The operations of a heap to test. The items of the heaps are strings. The keyed heaps order them by a key, and the
+ * indexed and pairing heaps associate each of them with a handle, which are given when an item is inserted and printed
+ * when it is removed.
+ */
+typedef struct {
+    // Initialize the heap
+    bool (*init) (Heap *heap, size_t arity);
+    // Free the resources of the heap
+    void (*destroy) (Heap *heap);
+    // Check if the heap is empty
+    bool (*is_empty) (Heap *heap);
+    // Return the size of the heap
+    size_t (*size) (Heap *heap);
+    // Insert an item to the heap, with its key or handle if the heap has them
+    bool (*insert) (Heap *heap, size_t key, char *item);
+    // Remove the minimum item from the heap, and set its key or handle if the heap has them, or return NULL
+    char *(*remove_min) (Heap *heap, size_t *key);
+    // Return the minimum item of the heap, and set its key or handle if the heap has them, or return NULL
+    char *(*peek) (Heap *heap, size_t *key);
+    // Whether the items have keys or handles
+    bool keyed;
+} HeapOps;
 
 /**
  * Compares two heap elements. The elements should be strings.
@@ -17,13 +80,360 @@ int compare_str(const void *a, const void *b) {
     return strcmp((const char *) a, (const char *) b);
 }
 
+static bool binary_init(Heap *heap, size_t arity) {
+    (void) arity;
+    return bh_init(&heap->bh, compare_str);
+}
+
+static void binary_destroy(Heap *heap) {
+    bh_destroy(&heap->bh);
+}
+
+static bool binary_is_empty(Heap *heap) {
+    return bh_is_empty(&heap->bh);
+}
+
+static size_t binary_size(Heap *heap) {
+    return bh_size(&heap->bh);
+}
+
+static bool binary_insert(Heap *heap, size_t key, char *item) {
+    (void) key;
+    return bh_insert(&heap->bh, item);
+}
+
+static char *binary_remove_min(Heap *heap, size_t *key) {
+    (void) key;
+    return bh_remove_min(&heap->bh);
+}
+
+static char *binary_peek(Heap *heap, size_t *key) {
+    (void) key;
+    return bh_peek(&heap->bh);
+}
+
+static bool dary_init(Heap *heap, size_t arity) {
+    return dh_init(&heap->dh, compare_str, arity);
+}
+
+static void dary_destroy(Heap *heap) {
+    dh_destroy(&heap->dh);
+}
+
+static bool dary_is_empty(Heap *heap) {
+    return dh_is_empty(&heap->dh);
+}
+
+static size_t dary_size(Heap *heap) {
+    return dh_size(&heap->dh);
+}
+
+static bool dary_insert(Heap *heap, size_t key, char *item) {
+    (void) key;
+    return dh_insert(&heap->dh, item);
+}
+
+static char *dary_remove_min(Heap *heap, size_t *key) {
+    (void) key;
+    return dh_remove_min(&heap->dh);
+}
+
+static char *dary_peek(Heap *heap, size_t *key) {
+    (void) key;
+    return dh_peek(&heap->dh);
+}
+
+static bool indexed_init(Heap *heap, size_t arity) {
+    (void) arity;
+    return ih_init(&heap->ih, compare_str);
+}
+
+static void indexed_destroy(Heap *heap) {
+    ih_destroy(&heap->ih);
+}
+
+static bool indexed_is_empty(Heap *heap) {
+    return ih_is_empty(&heap->ih);
+}
+
+static size_t indexed_size(Heap *heap) {
+    return ih_size(&heap->ih);
+}
+
+static bool indexed_insert(Heap *heap, size_t key, char *item) {
+    return ih_insert(&heap->ih, key, item);
+}
+
+static char *indexed_remove_min(Heap *heap, size_t *key) {
+    return ih_remove_min(&heap->ih, key);
+}
+
+static char *indexed_peek(Heap *heap, size_t *key) {
+    return ih_peek(&heap->ih, key);
+}
+
+static bool keyed_init(Heap *heap, size_t arity) {
+    (void) arity;
+    return kh_init(&heap->kh);
+}
+
+static void keyed_destroy(Heap *heap) {
+    kh_destroy(&heap->kh);
+}
+
+static bool keyed_is_empty(Heap *heap) {
+    return kh_is_empty(&heap->kh);
+}
+
+static size_t keyed_size(Heap *heap) {
+    return kh_size(&heap->kh);
+}
+
+static bool keyed_insert(Heap *heap, size_t key, char *item) {
+    return kh_insert(&heap->kh, key, item);
+}
+
+static char *keyed_remove_min(Heap *heap, size_t *key) {
+    uint64_t min_key = 0;
+    char *item = kh_remove_min(&heap->kh, &min_key);
+    *key = (size_t) min_key;
+
+    return item;
+}
+
+static char *keyed_peek(Heap *heap, size_t *key) {
+    uint64_t min_key = 0;
+    char *item = kh_peek(&heap->kh, &min_key);
+    *key = (size_t) min_key;
+
+    return item;
+}
+
+static bool pairing_init(Heap *heap, size_t arity) {
+    (void) arity;
+    heap->ph.nodes = NULL;
+    heap->ph.in_other = NULL;
+    heap->ph.capacity = 0;
+    return ph_init(&heap->ph.ph, compare_str) && ph_init(&heap->ph.other, compare_str);
+}
+
+static void pairing_destroy(Heap *heap) {
+    // The items that were not melded are only freed here
+    for (char *item = ph_remove_min(&heap->ph.other); item; item = ph_remove_min(&heap->ph.other)) {
+        free(item);
+    }
+    ph_destroy(&heap->ph.ph);
+    ph_destroy(&heap->ph.other);
+    free(heap->ph.nodes);
+    free(heap->ph.in_other);
+}
+
+static bool pairing_is_empty(Heap *heap) {
+    return ph_is_empty(&heap->ph.ph);
+}
+
+static size_t pairing_size(Heap *heap) {
+    return ph_size(&heap->ph.ph);
+}
+
+/**
+ * Insert an item with a handle to one of the heaps of a pairing heap, and keep its node.
+ *
+ * @param heap Pointer to the pairing heap.
+ * @param ph The heap to insert the item to, which is either the heap or the other heap.
+ * @param handle The handle of the item, which must not be used by another item.
+ * @param item The item.
+ * @return true if the item was inserted, false if the handle is used or the memory could not be allocated.
+ */
+static bool pairing_insert_to(PairingHeap *heap, PHeap *ph, size_t handle, char *item) {
+    if (handle >= heap->capacity) {
+        size_t capacity = 2 * heap->capacity > handle ? 2 * heap->capacity : handle + 1;
+        PHeapNode **nodes = realloc(heap->nodes, capacity * sizeof(PHeapNode *));
+        if (!nodes) {
+            return false;
+        }
+        heap->nodes = nodes;
+        bool *in_other = realloc(heap->in_other, capacity * sizeof(bool));
+        if (!in_other) {
+            return false;
+        }
+        heap->in_other = in_other;
+        for (size_t i = heap->capacity; i < capacity; i++) {
+            heap->nodes[i] = NULL;
+            heap->in_other[i] = false;
+        }
+        heap->capacity = capacity;
+    }
+    if (heap->nodes[handle] || !ph_insert(ph, item, &heap->nodes[handle])) {
+        return false;
+    }
+    heap->in_other[handle] = ph == &heap->other;
+
+    return true;
+}
+
+static bool pairing_insert(Heap *heap, size_t key, char *item) {
+    return pairing_insert_to(&heap->ph, &heap->ph.ph, key, item);
+}
+
+static size_t pairing_handle(PairingHeap *heap, const char *item) {
+    // Find the handle whose node has the item
+    size_t handle = 0;
+    while (!heap->nodes[handle] || heap->nodes[handle]->item != item) {
+        handle++;
+    }
+
+    return handle;
+}
+
+static char *pairing_remove_min(Heap *heap, size_t *key) {
+    char *item = ph_remove_min(&heap->ph.ph);
+    if (item) {
+        *key = pairing_handle(&heap->ph, item);
+        heap->ph.nodes[*key] = NULL;
+    }
+
+    return item;
+}
+
+static char *pairing_peek(Heap *heap, size_t *key) {
+    char *item = ph_peek(&heap->ph.ph);
+    if (item) {
+        *key = pairing_handle(&heap->ph, item);
+    }
+
+    return item;
+}
+
+static bool radix_init(Heap *heap, size_t arity) {
+    (void) arity;
+    return rh_init(&heap->rh);
+}
+
+static void radix_destroy(Heap *heap) {
+    rh_destroy(&heap->rh);
+}
+
+static bool radix_is_empty(Heap *heap) {
+    return rh_is_empty(&heap->rh);
+}
+
+static size_t radix_size(Heap *heap) {
+    return rh_size(&heap->rh);
+}
+
+static bool radix_insert(Heap *heap, size_t key, char *item) {
+    return rh_insert(&heap->rh, key, item);
+}
+
+static char *radix_remove_min(Heap *heap, size_t *key) {
+    uint64_t min_key = 0;
+    char *item = rh_remove_min(&heap->rh, &min_key);
+    *key = (size_t) min_key;
+
+    return item;
+}
+
+static char *radix_peek(Heap *heap, size_t *key) {
+    uint64_t min_key = 0;
+    char *item = rh_peek(&heap->rh, &min_key);
+    *key = (size_t) min_key;
+
+    return item;
+}
+
+static const HeapOps binary_ops = {
+    binary_init, binary_destroy, binary_is_empty, binary_size, binary_insert, binary_remove_min, binary_peek, false
+};
+static const HeapOps dary_ops = {
+    dary_init, dary_destroy, dary_is_empty, dary_size, dary_insert, dary_remove_min, dary_peek, false
+};
+static const HeapOps indexed_ops = {
+    indexed_init, indexed_destroy, indexed_is_empty, indexed_size, indexed_insert, indexed_remove_min, indexed_peek,
+    true
+};
+static const HeapOps keyed_ops = {
+    keyed_init, keyed_destroy, keyed_is_empty, keyed_size, keyed_insert, keyed_remove_min, keyed_peek, true
+};
+static const HeapOps pairing_ops = {
+    pairing_init, pairing_destroy, pairing_is_empty, pairing_size, pairing_insert, pairing_remove_min, pairing_peek,
+    true
+};
+static const HeapOps radix_ops = {
+    radix_init, radix_destroy, radix_is_empty, radix_size, radix_insert, radix_remove_min, radix_peek, true
+};
+
+/**
+ * Parse the arguments of a command of the indexed or pairing heap, which are a handle and optionally a string.
+ *
+ * @param line The command line, after the command.
+ * @param handle Set to the handle.
+ * @param str If not NULL, set to a copy of the string after the handle.
+ * @return true if the arguments were parsed, false otherwise.
+ */
+static bool parse_handle(const char *line, size_t *handle, char **str) {
+    char *end;
+    *handle = (size_t) strtoul(line, &end, 10);
+    if (end == line) {
+        return false;
+    }
+    if (str) {
+        if (*end != ' ') {
+            return false;
+        }
+        *str = strndup(end + 1, strcspn(end + 1, "\n"));
+        if (!*str) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 int main(int argc, char **argv) {
+    // Parse the command line arguments
+    static struct option long_options[] = {
+        {"indexed", no_argument, 0, 'i'},
+        {"arity", required_argument, 0, 'd'},
+        {"keyed", no_argument, 0, 'k'},
+        {"pairing", no_argument, 0, 'p'},
+        {"radix", no_argument, 0, 'r'},
+        {0, 0, 0, 0}
+    };
+    int option_index = 0;
+    int c;
+    const HeapOps *ops = &binary_ops;
+    size_t arity = 0;
+    while ((c = getopt_long(argc, argv, "id:kpr", long_options, &option_index)) != -1) {
+        switch (c) {
+            case 'i':
+                ops = &indexed_ops;
+                break;
+            case 'd':
+                ops = &dary_ops;
+                arity = (size_t) atoi(optarg);
+                break;
+            case 'k':
+                ops = &keyed_ops;
+                break;
+            case 'p':
+                ops = &pairing_ops;
+                break;
+            case 'r':
+                ops = &radix_ops;
+                break;
+            default:
+                fprintf(stderr, "Invalid option: %c\n", c);
+                return EXIT_FAILURE;
+        }
+    }
+
     // Check if a file was provided to be opened
     FILE *fp;
-    if (argc == 2) {
-        fp = fopen(argv[1], "r");
+    if (optind < argc) {
+        fp = fopen(argv[optind], "r");
         if (!fp) {
-            fprintf(stderr, "Could not open file: %s\n", argv[1]);
+            fprintf(stderr, "Could not open file: %s\n", argv[optind]);
             return EXIT_FAILURE;
         }
     } else {
@@ -31,54 +441,134 @@ int main(int argc, char **argv) {
     }
 
     // Initialize the heap
-    BHeap heap;
-    if (!bh_init(&heap, compare_str)) {
-        fprintf(stderr, "Cannot create heap.\n");
+    Heap heap;
+    if (!ops->init(&heap, arity)) {
+        fprintf(stderr, ops == &dary_ops ? "Cannot create heap, the arity must be 2, 4 or 8.\n" :
+                                           "Cannot create heap.\n");
+        fclose(fp);
         return EXIT_FAILURE;
     }
 
-    int return_val = EXIT_SUCCESS;
     // Read the input line by line
     char * line = NULL;
     size_t len = 0;
     ssize_t read;
+    size_t handle;
     while ((read = getline(&line, &len, fp)) != -1) {
+        char *s;
         if (strncmp(line, "is_empty", strlen("is_empty")) == 0) {
-            printf("%s\n", bh_is_empty(&heap) ? "empty" : "not empty");
+            printf("%s\n", ops->is_empty(&heap) ? "empty" : "not empty");
         } else if (strncmp(line, "size", strlen("size")) == 0) {
-            printf("%zu\n", bh_size(&heap));
+            printf("%zu\n", ops->size(&heap));
         } else if (strncmp(line, "insert ", strlen("insert ")) == 0) {
-            // Add the string after the command
-            char *str = strchr(line, ' ');
-            if (!str) {
+            if (ops->keyed) {
+                // Add the string after the key or the handle
+                if (!parse_handle(line + strlen("insert "), &handle, &s)) {
+                    fprintf(stderr, "Invalid input.\n");
+                    continue;
+                }
+            } else {
+                // Add the string after the command
+                s = strndup(line + strlen("insert "), strcspn(line + strlen("insert "), "\n"));
+                handle = 0;
+                if (!s) {
+                    fprintf(stderr, "Invalid input.\n");
+                    continue;
+                }
+            }
+            if (!ops->insert(&heap, handle, s)) {
+                fprintf(stderr, "Cannot insert to heap.\n");
+                free(s);
+            }
+        } else if (ops == &indexed_ops && (strncmp(line, "decrease_key ", strlen("decrease_key ")) == 0 ||
+                                           strncmp(line, "increase_key ", strlen("increase_key ")) == 0)) {
+            // Replace the string of the handle
+            if (!parse_handle(strchr(line, ' ') + 1, &handle, &s)) {
                 fprintf(stderr, "Invalid input.\n");
                 continue;
             }
-            str++;
-            char *s = strndup(str, strlen(str) - 1);
-            if (!bh_insert(&heap, s)) {
+            char *old = ih_get(&heap.ih, handle);
+            bool changed = line[0] == 'd' ? ih_decrease_key(&heap.ih, handle, s) : ih_increase_key(&heap.ih, handle, s);
+            if (changed) {
+                free(old);
+            } else {
+                fprintf(stderr, "Cannot %s key: %zu.\n", line[0] == 'd' ? "decrease" : "increase", handle);
+                free(s);
+            }
+        } else if (ops == &pairing_ops && strncmp(line, "decrease_key ", strlen("decrease_key ")) == 0) {
+            // Replace the string of the handle, in the heap that has it
+            if (!parse_handle(line + strlen("decrease_key "), &handle, &s)) {
+                fprintf(stderr, "Invalid input.\n");
+                continue;
+            }
+            PHeapNode *node = handle < heap.ph.capacity ? heap.ph.nodes[handle] : NULL;
+            char *old = node ? node->item : NULL;
+            if (node && ph_decrease_key(heap.ph.in_other[handle] ? &heap.ph.other : &heap.ph.ph, node, s)) {
+                free(old);
+            } else {
+                fprintf(stderr, "Cannot decrease key: %zu.\n", handle);
+                free(s);
+            }
+        } else if (ops == &pairing_ops && strncmp(line, "insert_other ", strlen("insert_other ")) == 0) {
+            // Add the string after the handle to the heap that is melded by the next meld command
+            if (!parse_handle(line + strlen("insert_other "), &handle, &s)) {
+                fprintf(stderr, "Invalid input.\n");
+                continue;
+            }
+            if (!pairing_insert_to(&heap.ph, &heap.ph.other, handle, s)) {
                 fprintf(stderr, "Cannot insert to heap.\n");
-                return_val = EXIT_FAILURE;
-                goto cleanup;
+                free(s);
+            }
+        } else if (ops == &pairing_ops && strncmp(line, "meld", strlen("meld")) == 0) {
+            ph_meld(&heap.ph.ph, &heap.ph.other);
+            for (size_t i = 0; i < heap.ph.capacity; i++) {
+                heap.ph.in_other[i] = false;
+            }
+        } else if (ops == &indexed_ops && strncmp(line, "contains ", strlen("contains ")) == 0) {
+            if (!parse_handle(line + strlen("contains "), &handle, NULL)) {
+                fprintf(stderr, "Invalid input.\n");
+                continue;
+            }
+            printf("%s\n", ih_contains(&heap.ih, handle) ? "true" : "false");
+        } else if (ops == &indexed_ops && strncmp(line, "remove ", strlen("remove ")) == 0) {
+            if (!parse_handle(line + strlen("remove "), &handle, NULL)) {
+                fprintf(stderr, "Invalid input.\n");
+                continue;
+            }
+            s = ih_remove(&heap.ih, handle);
+            if (s) {
+                printf("%s\n", s);
+                free(s);
+            } else {
+                fprintf(stderr, "Handle not in heap: %zu.\n", handle);
+            }
+        } else if (strncmp(line, "remove_min", strlen("remove_min")) == 0 ||
+                   strncmp(line, "peek", strlen("peek")) == 0) {
+            bool remove = line[0] == 'r';
+            s = remove ? ops->remove_min(&heap, &handle) : ops->peek(&heap, &handle);
+            if (!s) {
+                fprintf(stderr, "Heap is empty.\n");
+            } else if (ops->keyed) {
+                printf("%zu %s\n", handle, s);
+            } else {
+                printf("%s\n", s);
+            }
+            if (remove) {
+                free(s);
             }
-        } else if (strncmp(line, "remove_min", strlen("remove_min")) == 0) {
-            char *min = bh_remove_min(&heap);
-            printf("%s\n", min);
-            free(min);
-        } else if (strncmp(line, "peek", strlen("peek")) == 0) {
-            char *min = bh_peek(&heap);
-            printf("%s\n", min);
         } else {
             fprintf(stderr, "Invalid command: %.*s.\n", (int) read - 1, line);
             continue;
         }
     }
 
-cleanup:
     // Cleanup resources
-    bh_destroy(&heap);
+    for (char *item = ops->remove_min(&heap, &handle); item; item = ops->remove_min(&heap, &handle)) {
+        free(item);
+    }
+    ops->destroy(&heap);
     fclose(fp);
     free(line);
 
-    return return_val;
+    return EXIT_SUCCESS;
 }
@@ -0,0 +1,524 @@
+/**
+ * Benchmark program for the heaps. Each selected heap runs each selected workload, which mixes inserts and removals of
+ * the minimum in a different way. Every benchmark does some timed runs and reports the minimum and median of the
+ * running times. After each run the heap is drained, and the removed keys are checked to be in order. Heaps that need
+ * the removed keys to never decrease only run the workloads that are monotone.
+ */
+#include "bheap.h"
+#include "dheap.h"
+#include "kheap.h"
+#include "pheap.h"
+#include "rheap.h"
+
+#include <getopt.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// The default number of operations of each workload
+#define DEFAULT_NUM_OPERATIONS 1000000
+// The default number of timed runs of each benchmark
+#define DEFAULT_RUNS 5
+// The range of the random keys
+#define KEY_RANGE 1000000000
+// The maximum increment of the keys that are inserted back by the hold workload
+#define HOLD_INCREMENT 1000
+
+/**
+ * The heap data structures that are benchmarked.
+ */
+typedef union {
+    BHeap bh;
+    DHeap dh;
+    KHeap kh;
+    PHeap ph;
+    RHeap rh;
+} Heap;
+
+/**
+ * A heap to benchmark. The items of the heaps are pointers to unsigned 64-bit keys.
+ */
+typedef struct {
+    // The name of the heap
+    const char *name;
+    // Initialize the heap
+    bool (*init) (Heap *heap);
+    // Free the resources of the heap
+    void (*destroy) (Heap *heap);
+    // Insert an item to the heap
+    bool (*insert) (Heap *heap, uint64_t *item);
+    // Remove the minimum item from the heap, or return NULL if it is empty
+    uint64_t *(*remove_min) (Heap *heap);
+    // Load an array of items to the empty heap, or NULL if the items are inserted one by one
+    bool (*build) (Heap *heap, uint64_t **items, size_t n);
+    // Whether the heap needs the inserted keys to not be smaller than the last removed key
+    bool monotone;
+} HeapType;
+
+/**
+ * Prototype for a function that runs a workload on a heap.
+ *
+ * @param type The heap type.
+ * @param heap The initialized heap.
+ * @param keys The keys of the items, with room for n keys, of which n are initialized to random values.
+ * @param n The number of operations.
+ * @param seconds Set to the running time of the timed part of the workload.
+ * @return true if the workload was run, false if the heap could not allocate memory.
+ */
+typedef bool (*WORKLOAD_FUNC) (const HeapType *type, Heap *heap, uint64_t *keys, size_t n, double *seconds);
+
+/**
+ * A workload to benchmark.
+ */
+typedef struct {
+    // The name of the workload
+    const char *name;
+    // The function that runs the workload
+    WORKLOAD_FUNC run;
+    // Whether the inserted keys are never smaller than the last removed key
+    bool monotone;
+} Workload;
+
+/**
+ * Returns the number of seconds elapsed from an arbitrary point, by a monotonic clock.
+ *
+ * @return The number of seconds.
+ */
+static double get_time(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/**
+ * Compares two unsigned 64-bit integers.
+ *
+ * @param first The first integer.
+ * @param second The second integer.
+ * @return 1 if the first integer is greater that the second, -1 if the first is less than the second, and 0 if they
+ * are equal.
+ */
+static int compare_u64(const void *first, const void *second) {
+    uint64_t ufirst = *((const uint64_t *) first);
+    uint64_t usecond = *((const uint64_t *) second);
+
+    return (ufirst > usecond) - (ufirst < usecond);
+}
+
+static bool binary_init(Heap *heap) {
+    return bh_init(&heap->bh, compare_u64);
+}
+
+static void binary_destroy(Heap *heap) {
+    bh_destroy(&heap->bh);
+}
+
+static bool binary_insert(Heap *heap, uint64_t *item) {
+    return bh_insert(&heap->bh, item);
+}
+
+static uint64_t *binary_remove_min(Heap *heap) {
+    return bh_remove_min(&heap->bh);
+}
+
+static bool binary_reserve_build(Heap *heap, uint64_t **items, size_t n) {
+    // Make room for the items once, and insert them one by one
+    if (!bh_reserve(&heap->bh, n)) {
+        return false;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (!bh_insert(&heap->bh, items[i])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool binary_insert_batch(Heap *heap, uint64_t **items, size_t n) {
+    return bh_insert_batch(&heap->bh, (void **) items, n);
+}
+
+static bool binary_init_from_array(Heap *heap, uint64_t **items, size_t n) {
+    // Replace the empty heap with one that is built from the items. If that fails, the heap is initialized again so
+    // that it can be destroyed.
+    bh_destroy(&heap->bh);
+    if (!bh_init_from_array(&heap->bh, compare_u64, (void **) items, n)) {
+        bh_init(&heap->bh, compare_u64);
+        return false;
+    }
+
+    return true;
+}
+
+static bool dary4_init(Heap *heap) {
+    return dh_init(&heap->dh, compare_u64, 4);
+}
+
+static bool dary8_init(Heap *heap) {
+    return dh_init(&heap->dh, compare_u64, 8);
+}
+
+static void dary_destroy(Heap *heap) {
+    dh_destroy(&heap->dh);
+}
+
+static bool dary_insert(Heap *heap, uint64_t *item) {
+    return dh_insert(&heap->dh, item);
+}
+
+static uint64_t *dary_remove_min(Heap *heap) {
+    return dh_remove_min(&heap->dh);
+}
+
+static bool keyed_init(Heap *heap) {
+    return kh_init(&heap->kh);
+}
+
+static void keyed_destroy(Heap *heap) {
+    kh_destroy(&heap->kh);
+}
+
+static bool keyed_insert(Heap *heap, uint64_t *item) {
+    return kh_insert(&heap->kh, *item, item);
+}
+
+static uint64_t *keyed_remove_min(Heap *heap) {
+    return kh_remove_min(&heap->kh, NULL);
+}
+
+static bool pairing_init(Heap *heap) {
+    return ph_init(&heap->ph, compare_u64);
+}
+
+static void pairing_destroy(Heap *heap) {
+    ph_destroy(&heap->ph);
+}
+
+static bool pairing_insert(Heap *heap, uint64_t *item) {
+    return ph_insert(&heap->ph, item, NULL);
+}
+
+static uint64_t *pairing_remove_min(Heap *heap) {
+    return ph_remove_min(&heap->ph);
+}
+
+static bool radix_init(Heap *heap) {
+    return rh_init(&heap->rh);
+}
+
+static void radix_destroy(Heap *heap) {
+    rh_destroy(&heap->rh);
+}
+
+static bool radix_insert(Heap *heap, uint64_t *item) {
+    return rh_insert(&heap->rh, *item, item);
+}
+
+static uint64_t *radix_remove_min(Heap *heap) {
+    return rh_remove_min(&heap->rh, NULL);
+}
+
+/**
+ * The insert heavy workload: three inserts for every removal of the minimum, so the heap grows to 3n / 4 items.
+ */
+static bool run_insert_heavy(const HeapType *type, Heap *heap, uint64_t *keys, size_t n, double *seconds) {
+    double start = get_time();
+    for (size_t i = 0; i < n; i++) {
+        if (i % 4 == 3) {
+            type->remove_min(heap);
+        } else if (!type->insert(heap, &keys[i])) {
+            return false;
+        }
+    }
+    *seconds = get_time() - start;
+
+    return true;
+}
+
+/**
+ * The pop heavy workload: the heap is filled with n items, which are not timed, and then all of them are removed.
+ */
+static bool run_pop_heavy(const HeapType *type, Heap *heap, uint64_t *keys, size_t n, double *seconds) {
+    for (size_t i = 0; i < n; i++) {
+        if (!type->insert(heap, &keys[i])) {
+            return false;
+        }
+    }
+    double start = get_time();
+    for (size_t i = 0; i < n; i++) {
+        type->remove_min(heap);
+    }
+    *seconds = get_time() - start;
+
+    return true;
+}
+
+/**
+ * The hold workload, as used by event schedulers: the heap is filled with the first half of the n items, rounded up,
+ * which are not timed, and then each operation removes the minimum and inserts it back with a bigger key, so the keys
+ * that are removed never decrease. The heap is never empty when the minimum is removed.
+ */
+static bool run_hold(const HeapType *type, Heap *heap, uint64_t *keys, size_t n, double *seconds) {
+    size_t filled = n - n / 2;
+    for (size_t i = 0; i < filled; i++) {
+        if (!type->insert(heap, &keys[i])) {
+            return false;
+        }
+    }
+    double start = get_time();
+    for (size_t i = filled; i < n; i++) {
+        uint64_t *item = type->remove_min(heap);
+        if (!item) {
+            // The radix heap could not allocate memory to remove the minimum
+            return false;
+        }
+        *item += keys[i] % HOLD_INCREMENT;
+        if (!type->insert(heap, item)) {
+            return false;
+        }
+    }
+    *seconds = get_time() - start;
+
+    return true;
+}
+
+/**
+ * The build workload, as done when a heap is loaded: n items are inserted to the empty heap, all at once by the build
+ * function of the heap if it has one.
+ */
+static bool run_build(const HeapType *type, Heap *heap, uint64_t *keys, size_t n, double *seconds) {
+    uint64_t **items = malloc((n > 0 ? n : 1) * sizeof(uint64_t *));
+    if (!items) {
+        return false;
+    }
+    for (size_t i = 0; i < n; i++) {
+        items[i] = &keys[i];
+    }
+    bool inserted = true;
+    double start = get_time();
+    if (type->build) {
+        inserted = type->build(heap, items, n);
+    } else {
+        for (size_t i = 0; i < n && inserted; i++) {
+            inserted = type->insert(heap, items[i]);
+        }
+    }
+    *seconds = get_time() - start;
+    free(items);
+
+    return inserted;
+}
+
+static const HeapType heap_types[] = {
+    {"binary", binary_init, binary_destroy, binary_insert, binary_remove_min, binary_reserve_build, false},
+    {"batch", binary_init, binary_destroy, binary_insert, binary_remove_min, binary_insert_batch, false},
+    {"array", binary_init, binary_destroy, binary_insert, binary_remove_min, binary_init_from_array, false},
+    {"4-ary", dary4_init, dary_destroy, dary_insert, dary_remove_min, NULL, false},
+    {"8-ary", dary8_init, dary_destroy, dary_insert, dary_remove_min, NULL, false},
+    {"keyed", keyed_init, keyed_destroy, keyed_insert, keyed_remove_min, NULL, false},
+    {"pairing", pairing_init, pairing_destroy, pairing_insert, pairing_remove_min, NULL, false},
+    {"radix", radix_init, radix_destroy, radix_insert, radix_remove_min, NULL, true}
+};
+#define NUM_HEAP_TYPES (sizeof(heap_types) / sizeof(heap_types[0]))
+
+static const Workload workloads[] = {
+    {"insert-heavy", run_insert_heavy, false},
+    {"pop-heavy", run_pop_heavy, true},
+    {"hold", run_hold, true},
+    {"build", run_build, true}
+};
+#define NUM_WORKLOADS (sizeof(workloads) / sizeof(workloads[0]))
+
+/**
+ * Select items by a comma separated list of names, or all of them if a name is "all".
+ *
+ * @param list The comma separated list. It is modified.
+ * @param names The names of the items, each one in the first member of a structure.
+ * @param count The number of items.
+ * @param stride The size in bytes of the structures.
+ * @param selected Set to true for each selected item.
+ * @return true if all names are valid, false otherwise.
+ */
+static bool select_names(char *list, const void *names, size_t count, size_t stride, bool *selected) {
+    for (char *name = strtok(list, ","); name; name = strtok(NULL, ",")) {
+        bool all = strcmp(name, "all") == 0;
+        bool found = all;
+        for (size_t i = 0; i < count; i++) {
+            const char *item = *((const char * const *) ((const char *) names + i * stride));
+            if (all || strcmp(name, item) == 0) {
+                selected[i] = true;
+                found = true;
+            }
+        }
+        if (!found) {
+            fprintf(stderr, "Invalid name: %s\n", name);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Compares two running times.
+ *
+ * @param first The first running time.
+ * @param second The second running time.
+ * @return 1 if the first time is greater that the second, -1 if the first is less than the second, and 0 if they are
+ * equal.
+ */
+static int compare_double(const void *first, const void *second) {
+    double dfirst = *((const double *) first);
+    double dsecond = *((const double *) second);
+
+    return (dfirst > dsecond) - (dfirst < dsecond);
+}
+
+/**
+ * Run a workload on a heap a number of times.
+ *
+ * @param type The heap type.
+ * @param workload The workload.
+ * @param keys The array of the keys, with room for n keys.
+ * @param n The number of operations.
+ * @param runs The number of timed runs.
+ * @param seed The seed of the random keys.
+ * @param times The array where the running times are stored, with room for runs times.
+ * @param ordered Set to true if the heap removed the keys in order.
+ * @return true if the benchmark was run, false if memory could not be allocated.
+ */
+static bool benchmark_heap(const HeapType *type, const Workload *workload, uint64_t *keys, size_t n, size_t runs,
+                           unsigned seed, double *times, bool *ordered) {
+    *ordered = true;
+    for (size_t run = 0; run < runs; run++) {
+        srand(seed);
+        for (size_t i = 0; i < n; i++) {
+            keys[i] = (uint64_t) rand() % KEY_RANGE;
+        }
+        Heap heap;
+        if (!type->init(&heap)) {
+            return false;
+        }
+        if (!workload->run(type, &heap, keys, n, &times[run])) {
+            type->destroy(&heap);
+            return false;
+        }
+        // Drain the heap, and check that the keys are removed in order
+        uint64_t previous = 0;
+        for (uint64_t *item = type->remove_min(&heap); item; item = type->remove_min(&heap)) {
+            if (*item < previous) {
+                *ordered = false;
+            }
+            previous = *item;
+        }
+        type->destroy(&heap);
+    }
+    qsort(times, runs, sizeof(double), compare_double);
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    static struct option long_options[] = {
+        {"heap", required_argument, 0, 'H'},
+        {"workload", required_argument, 0, 'w'},
+        {"num", required_argument, 0, 'n'},
+        {"runs", required_argument, 0, 'r'},
+        {"seed", required_argument, 0, 'S'},
+        {0, 0, 0, 0}
+    };
+    int option_index = 0;
+    int c;
+    bool selected_heaps[NUM_HEAP_TYPES] = {false};
+    bool heap_given = false;
+    bool selected_workloads[NUM_WORKLOADS] = {false};
+    bool workload_given = false;
+    size_t num_operations = DEFAULT_NUM_OPERATIONS;
+    size_t runs = DEFAULT_RUNS;
+    unsigned seed = 1;
+    while ((c = getopt_long(argc, argv, "H:w:n:r:S:", long_options, &option_index)) != -1) {
+        switch(c) {
+            case 'H':
+                if (!select_names(optarg, heap_types, NUM_HEAP_TYPES, sizeof(HeapType), selected_heaps)) {
+                    return EXIT_FAILURE;
+                }
+                heap_given = true;
+                break;
+            case 'w':
+                if (!select_names(optarg, workloads, NUM_WORKLOADS, sizeof(Workload), selected_workloads)) {
+                    return EXIT_FAILURE;
+                }
+                workload_given = true;
+                break;
+            case 'n':
+                num_operations = (size_t) atol(optarg);
+                break;
+            case 'r':
+                runs = (size_t) atol(optarg);
+                if (runs == 0) {
+                    fprintf(stderr, "The number of runs must be positive.\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'S':
+                seed = (unsigned) strtoul(optarg, NULL, 10);
+                break;
+            default:
+                fprintf(stderr, "Invalid option: %c\n", c);
+                return EXIT_FAILURE;
+        }
+    }
+    // By default, all heaps run all workloads
+    for (size_t i = 0; i < NUM_HEAP_TYPES; i++) {
+        selected_heaps[i] = selected_heaps[i] || !heap_given;
+    }
+    for (size_t i = 0; i < NUM_WORKLOADS; i++) {
+        selected_workloads[i] = selected_workloads[i] || !workload_given;
+    }
+
+    // Allocate the keys and the running times
+    uint64_t *keys = malloc((num_operations > 0 ? num_operations : 1) * sizeof(uint64_t));
+    double *times = malloc(runs * sizeof(double));
+    if (!keys || !times) {
+        fprintf(stderr, "Cannot allocate memory.\n");
+        free(keys);
+        free(times);
+        return EXIT_FAILURE;
+    }
+
+    // Run the benchmarks
+    int return_val = EXIT_SUCCESS;
+    printf("%-10s %-14s %10s %12s %12s %s\n", "heap", "workload", "n", "min", "median", "ordered");
+    for (size_t w = 0; w < NUM_WORKLOADS; w++) {
+        if (!selected_workloads[w]) {
+            continue;
+        }
+        for (size_t h = 0; h < NUM_HEAP_TYPES; h++) {
+            if (!selected_heaps[h] || (heap_types[h].monotone && !workloads[w].monotone)) {
+                continue;
+            }
+            bool ordered;
+            if (!benchmark_heap(&heap_types[h], &workloads[w], keys, num_operations, runs, seed, times, &ordered)) {
+                fprintf(stderr, "Cannot allocate memory.\n");
+                return_val = EXIT_FAILURE;
+                goto cleanup;
+            }
+            printf("%-10s %-14s %10zu %12.6f %12.6f %s\n", heap_types[h].name, workloads[w].name, num_operations,
+                   times[0], times[runs / 2], ordered ? "yes" : "no");
+            if (!ordered) {
+                return_val = EXIT_FAILURE;
+            }
+        }
+    }
+
+cleanup:
+    free(keys);
+    free(times);
+
+    return return_val;
+}
@@ -0,0 +1,186 @@
+/**
+ * Test program for the sorting networks. Every array size up to SORT_NETWORK_MAX is sorted for each key type, and
+ * every pair of run lengths up to MERGE_MAX_RUN is merged, both to a separate array and in place with the right run at
+ * the end of the destination. The results are compared to qsort. The arrays are drawn from random keys and from the
+ * extreme values of each type, so that they have duplicates and keys on both sides of the sign bit. Set the
+ * environment variable SORT_NETWORK_ISA to "sse4.2" or "scalar" to test the fallback code of the networks.
+ */
+#include "sort_network.h"
+
+#include <getopt.h>
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+// The default number of random arrays of each size and key type
+#define DEFAULT_TRIALS 1000
+// The maximum length of the merged runs, which covers a few blocks of 8 and 4 keys of the merge networks
+#define MERGE_MAX_RUN 40
+// The number of trials per merge of each pair of run lengths is the number of trials divided by this
+#define MERGE_TRIALS_DIVISOR 50
+
+/**
+ * Returns a random unsigned 64-bit integer, which is one of a few extreme values one time in four.
+ *
+ * @return The random integer.
+ */
+static uint64_t random_u64(void) {
+    static const uint64_t extremes[] = {
+        0, 1, UINT32_MAX >> 1, (UINT64_C(1) << 31), UINT32_MAX, (UINT64_C(1) << 32), UINT64_MAX >> 1,
+        UINT64_C(1) << 63, UINT64_MAX
+    };
+    if (rand() % 4 == 0) {
+        return extremes[(size_t) rand() % (sizeof(extremes) / sizeof(extremes[0]))];
+    }
+    uint64_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        value = (value << 16) ^ (uint64_t) (rand() & 0xffff);
+    }
+
+    return value;
+}
+
+/**
+ * Define the comparison function of a key type for qsort.
+ *
+ * @param name The name of the key type.
+ * @param type The key type.
+ */
+#define DEFINE_COMPARE(name, type) \
+    static int compare_##name(const void *first, const void *second) { \
+        type a = *((const type *) first); \
+        type b = *((const type *) second); \
+        return (a > b) - (a < b); \
+    }
+
+DEFINE_COMPARE(i32, int32_t)
+DEFINE_COMPARE(u32, uint32_t)
+DEFINE_COMPARE(i64, int64_t)
+DEFINE_COMPARE(u64, uint64_t)
+
+/**
+ * Define a function that checks the sorting network of a key type against qsort for every array size, and prints the
+ * first array that is sorted wrongly.
+ *
+ * @param name The name of the key type.
+ * @param type The key type.
+ */
+#define DEFINE_CHECK_SORT(name, type) \
+    static bool check_sort_##name(size_t trials) { \
+        type keys[SORT_NETWORK_MAX]; \
+        type expected[SORT_NETWORK_MAX]; \
+        for (size_t n = 0; n <= SORT_NETWORK_MAX; n++) { \
+            for (size_t t = 0; t < trials; t++) { \
+                for (size_t i = 0; i < n; i++) { \
+                    keys[i] = (type) random_u64(); \
+                } \
+                memcpy(expected, keys, n * sizeof(type)); \
+                qsort(expected, n, sizeof(type), compare_##name); \
+                sort_network_##name(keys, n); \
+                if (memcmp(keys, expected, n * sizeof(type)) != 0) { \
+                    fprintf(stderr, "sort_network_" #name " failed for %zu keys:", n); \
+                    for (size_t i = 0; i < n; i++) { \
+                        fprintf(stderr, " %" PRIu64, (uint64_t) keys[i]); \
+                    } \
+                    fprintf(stderr, "\n"); \
+                    return false; \
+                } \
+            } \
+        } \
+        return true; \
+    }
+
+DEFINE_CHECK_SORT(i32, int32_t)
+DEFINE_CHECK_SORT(u32, uint32_t)
+DEFINE_CHECK_SORT(i64, int64_t)
+DEFINE_CHECK_SORT(u64, uint64_t)
+
+/**
+ * Define a function that checks the merge network of a key type against qsort for every pair of run lengths, and
+ * prints the first pair that is merged wrongly. Each pair is merged to a separate array, and in place, with the right
+ * run at the end of the destination after room for the left run.
+ *
+ * @param name The name of the key type.
+ * @param type The key type.
+ */
+#define DEFINE_CHECK_MERGE(name, type) \
+    static bool check_merge_##name(size_t trials) { \
+        type left[MERGE_MAX_RUN]; \
+        type right[MERGE_MAX_RUN]; \
+        type dest[2 * MERGE_MAX_RUN]; \
+        type expected[2 * MERGE_MAX_RUN]; \
+        for (size_t n1 = 0; n1 <= MERGE_MAX_RUN; n1++) { \
+            for (size_t n2 = 0; n2 <= MERGE_MAX_RUN; n2++) { \
+                for (size_t t = 0; t < trials; t++) { \
+                    for (size_t i = 0; i < n1; i++) { \
+                        left[i] = (type) random_u64(); \
+                    } \
+                    for (size_t i = 0; i < n2; i++) { \
+                        right[i] = (type) random_u64(); \
+                    } \
+                    qsort(left, n1, sizeof(type), compare_##name); \
+                    qsort(right, n2, sizeof(type), compare_##name); \
+                    memcpy(expected, left, n1 * sizeof(type)); \
+                    memcpy(expected + n1, right, n2 * sizeof(type)); \
+                    qsort(expected, n1 + n2, sizeof(type), compare_##name); \
+                    for (int in_place = 0; in_place < 2; in_place++) { \
+                        if (in_place) { \
+                            memcpy(dest + n1, right, n2 * sizeof(type)); \
+                            sort_network_merge_##name(dest, left, n1, dest + n1, n2); \
+                        } else { \
+                            sort_network_merge_##name(dest, left, n1, right, n2); \
+                        } \
+                        if (memcmp(dest, expected, (n1 + n2) * sizeof(type)) != 0) { \
+                            fprintf(stderr, "sort_network_merge_" #name " failed for runs of %zu and %zu keys%s.\n", \
+                                    n1, n2, in_place ? " in place" : ""); \
+                            return false; \
+                        } \
+                    } \
+                } \
+            } \
+        } \
+        return true; \
+    }
+
+DEFINE_CHECK_MERGE(i32, int32_t)
+DEFINE_CHECK_MERGE(u32, uint32_t)
+DEFINE_CHECK_MERGE(i64, int64_t)
+DEFINE_CHECK_MERGE(u64, uint64_t)
+
+int main(int argc, char **argv) {
+    static struct option long_options[] = {
+        {"trials", required_argument, 0, 't'},
+        {"seed", required_argument, 0, 'S'},
+        {0, 0, 0, 0}
+    };
+    int option_index = 0;
+    int c;
+    size_t trials = DEFAULT_TRIALS;
+    unsigned seed = 1;
+    while ((c = getopt_long(argc, argv, "t:S:", long_options, &option_index)) != -1) {
+        switch (c) {
+            case 't':
+                trials = (size_t) atol(optarg);
+                break;
+            case 'S':
+                seed = (unsigned) atol(optarg);
+                break;
+            default:
+                fprintf(stderr, "Invalid option: %c\n", c);
+                return EXIT_FAILURE;
+        }
+    }
+
+    srand(seed);
+    const char *isa = getenv("SORT_NETWORK_ISA");
+    bool ok = check_sort_i32(trials) && check_sort_u32(trials) && check_sort_i64(trials) && check_sort_u64(trials);
+    size_t merge_trials = trials / MERGE_TRIALS_DIVISOR > 0 ? trials / MERGE_TRIALS_DIVISOR : 1;
+    ok = ok && check_merge_i32(merge_trials) && check_merge_u32(merge_trials) && check_merge_i64(merge_trials) &&
+         check_merge_u64(merge_trials);
+    printf("Sorting networks on %s code: %s\n", isa && *isa ? isa : "the best", ok ? "passed" : "FAILED");
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,26 +1,127 @@
 /**
- * Test program for sorting.
+ * Benchmark program for sorting. Each selected algorithm sorts arrays of each selected input distribution and element
+ * size. Every benchmark does a run that counts the comparisons and checks the result against qsort, some warmup runs,
+ * and some timed runs, and reports the minimum, median and 95th percentile of the running times. The results are
+ * printed as text, CSV or JSON.
  */
 #include "sorting.h"
+#include "typed_sort.h"
 
 #include <getopt.h>
-#include <sys/time.h>
 
+#include <limits.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
 
+// The default number of elements to sort
+#define DEFAULT_NUM_ELEMENTS 100000
+// The default number of timed runs of each benchmark
+#define DEFAULT_RUNS 5
+// The default number of warmup runs of each benchmark
+#define DEFAULT_WARMUP 1
+// The default number of distinct values of the few unique distribution
+#define DEFAULT_UNIQUE 16
+// The number of elements above which the quadratic sorts are only run if they are selected by name
+#define QUADRATIC_LIMIT 100000
+// The maximum number of distinct values of the Zipf distribution
+#define ZIPF_MAX_RANKS (1 << 20)
+// The maximum number of element sizes to benchmark
+#define MAX_ELEMENT_SIZES 16
+
+// The algorithm runs in quadratic time
+#define ALGORITHM_QUADRATIC 1
+// The algorithm only sorts integers
+#define ALGORITHM_INT 2
+// The algorithm only sorts unsigned 64-bit integers
+#define ALGORITHM_U64 4
+// The algorithm only sorts long integers
+#define ALGORITHM_LONG 8
+// The algorithm only sorts doubles
+#define ALGORITHM_DOUBLE 16
+// The number of characters of the strings that the typed string sorts compare, with the terminating null
+#define KEY_STRING_SIZE 12
+
+/**
+ * A sorting algorithm to benchmark.
+ */
+typedef struct {
+    // The name of the algorithm
+    const char *name;
+    // The sort function
+    SORT_FUNC sort;
+    // The flags of the algorithm
+    unsigned flags;
+} Algorithm;
+
+/**
+ * Prototype for a function that initializes an array of records with keys from an input distribution.
+ *
+ * @param array The array to initialize.
+ * @param n The number of elements in the array.
+ * @param size The size in bytes of each element in the array.
+ * @param unique The number of distinct values, for the distributions that use it.
+ * @return true if the array was initialized, false if memory could not be allocated.
+ */
+typedef bool (*INIT_FUNC) (void *array, size_t n, size_t size, int unique);
+
+/**
+ * An input distribution to benchmark.
+ */
+typedef struct {
+    // The name of the distribution
+    const char *name;
+    // The function that initializes the array
+    INIT_FUNC init;
+} Distribution;
+
+/**
+ * The output format of the results.
+ */
+typedef enum {
+    FORMAT_TEXT,
+    FORMAT_CSV,
+    FORMAT_JSON
+} Format;
+
 /**
- * Returns the number of milliseconds since the UNIX epoch.
+ * The results of a benchmark.
+ */
+typedef struct {
+    // The minimum running time in seconds
+    double min;
+    // The median running time in seconds
+    double median;
+    // The 95th percentile of the running time in seconds
+    double p95;
+    // The number of comparisons
+    unsigned long long comparisons;
+    // The statistics of the sort, if the library counts them
+    SortStats stats;
+    // true if the array was sorted to the same elements as qsort
+    bool sorted;
+} Result;
+
+// The number of comparisons made by compare_int_counting
+static atomic_ullong comparisons;
+// true during the run whose result is checked, in which the sorts that are built on the selection functions check
+// their partial results as well
+static bool checking;
+// Set by the sorts that are built on the selection functions if a partial result is wrong
+static bool selection_failed;
+
+/**
+ * Returns the number of seconds elapsed from an arbitrary point, by a monotonic clock.
  *
- * @return The number of milliseconds since the UNIX epoch.
+ * @return The number of seconds.
  */
-double get_time(void) {
-    struct timeval t;
-    gettimeofday(&t, NULL);
+static double get_time(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
 
-    return t.tv_sec + t.tv_usec * 1e-6;
+    return t.tv_sec + t.tv_nsec * 1e-9;
 }
 
 /**
@@ -44,94 +145,1121 @@ static int compare_int(const void *first, const void *second) {
 }
 
 /**
- * Initialize an integer array with random values.
+ * Compares two integer numbers, and counts the comparison. The sorts may call it from many threads.
+ *
+ * @param first The first integer.
+ * @param second The second integer.
+ * @return The result of compare_int.
+ */
+static int compare_int_counting(const void *first, const void *second) {
+    atomic_fetch_add_explicit(&comparisons, 1, memory_order_relaxed);
+
+    return compare_int(first, second);
+}
+
+/**
+ * Compares two doubles.
+ *
+ * @param first The first double.
+ * @param second The second double.
+ * @return 1 if the first double is greater, -1 if it is less, and 0 if they are equal.
+ */
+static int compare_double(const void *first, const void *second) {
+    double dfirst = *((const double *) first);
+    double dsecond = *((const double *) second);
+
+    return (dfirst > dsecond) - (dfirst < dsecond);
+}
+
+/**
+ * Set the key of an array element. The elements are records whose first member is an integer key, and the rest of
+ * the record is padding.
+ *
+ * @param array The array.
+ * @param i The index of the element.
+ * @param size The size in bytes of each element in the array.
+ * @param key The key.
+ */
+static void set_key(void *array, size_t i, size_t size, int key) {
+    memcpy((char *) array + i * size, &key, sizeof(int));
+}
+
+/**
+ * Swap the keys of two array elements.
+ *
+ * @param array The array.
+ * @param i The index of the first element.
+ * @param j The index of the second element.
+ * @param size The size in bytes of each element in the array.
+ */
+static void swap_keys(void *array, size_t i, size_t j, size_t size) {
+    int first;
+    int second;
+    memcpy(&first, (char *) array + i * size, sizeof(int));
+    memcpy(&second, (char *) array + j * size, sizeof(int));
+    set_key(array, i, size, second);
+    set_key(array, j, size, first);
+}
+
+/**
+ * Initialize an array with random values.
  *
  * @param array The array to initialize.
- * @param size The size of the array.
+ * @param n The number of elements in the array.
+ * @param size The size in bytes of each element in the array.
+ * @param unique Not used.
+ * @return true.
  */
-static void init_int_array_random(int *array, size_t size) {
-    for (size_t i = 0; i < size; ++i) {
-        array[i] = rand();
+static bool init_array_random(void *array, size_t n, size_t size, int unique) {
+    (void) unique;
+    for (size_t i = 0; i < n; ++i) {
+        set_key(array, i, size, rand());
     }
+
+    return true;
 }
 
 /**
- * Benchmarks a sort function.
+ * Initialize an array with sorted values.
+ *
+ * @param array The array to initialize.
+ * @param n The number of elements in the array.
+ * @param size The size in bytes of each element in the array.
+ * @param unique Not used.
+ * @return true.
+ */
+static bool init_array_sorted(void *array, size_t n, size_t size, int unique) {
+    (void) unique;
+    for (size_t i = 0; i < n; ++i) {
+        set_key(array, i, size, (int) i);
+    }
+
+    return true;
+}
+
+/**
+ * Initialize an array with values sorted in reverse order.
+ *
+ * @param array The array to initialize.
+ * @param n The number of elements in the array.
+ * @param size The size in bytes of each element in the array.
+ * @param unique Not used.
+ * @return true.
+ */
+static bool init_array_reversed(void *array, size_t n, size_t size, int unique) {
+    (void) unique;
+    for (size_t i = 0; i < n; ++i) {
+        set_key(array, i, size, (int) (n - i));
+    }
+
+    return true;
+}
+
+/**
+ * Initialize an array with values that increase up to the middle of the array, and then decrease.
+ *
+ * @param array The array to initialize.
+ * @param n The number of elements in the array.
+ * @param size The size in bytes of each element in the array.
+ * @param unique Not used.
+ * @return true.
+ */
+static bool init_array_organ_pipe(void *array, size_t n, size_t size, int unique) {
+    (void) unique;
+    for (size_t i = 0; i < n; ++i) {
+        set_key(array, i, size, (int) (i < n / 2 ? i : n - 1 - i));
+    }
+
+    return true;
+}
+
+/**
+ * Initialize an array with random values, out of a few distinct values.
+ *
+ * @param array The array to initialize.
+ * @param n The number of elements in the array.
+ * @param size The size in bytes of each element in the array.
+ * @param unique The number of distinct values.
+ * @return true.
+ */
+static bool init_array_few_unique(void *array, size_t n, size_t size, int unique) {
+    for (size_t i = 0; i < n; ++i) {
+        set_key(array, i, size, rand() % unique);
+    }
+
+    return true;
+}
+
+/**
+ * Initialize an array with sixteen sorted runs of increasing values.
+ *
+ * @param array The array to initialize.
+ * @param n The number of elements in the array.
+ * @param size The size in bytes of each element in the array.
+ * @param unique Not used.
+ * @return true.
+ */
+static bool init_array_sawtooth(void *array, size_t n, size_t size, int unique) {
+    (void) unique;
+    size_t period = (n + 15) / 16;
+    for (size_t i = 0; i < n; ++i) {
+        set_key(array, i, size, (int) (i % period));
+    }
+
+    return true;
+}
+
+/**
+ * Initialize an array with random values that follow a Zipf distribution: the value k appears with probability
+ * proportional to 1 / (k + 1).
+ *
+ * @param array The array to initialize.
+ * @param n The number of elements in the array.
+ * @param size The size in bytes of each element in the array.
+ * @param unique Not used.
+ * @return true if the array was initialized, false if memory could not be allocated.
+ */
+static bool init_array_zipf(void *array, size_t n, size_t size, int unique) {
+    (void) unique;
+    size_t ranks = n < ZIPF_MAX_RANKS ? n : ZIPF_MAX_RANKS;
+    if (ranks == 0) {
+        return true;
+    }
+    // Compute the cumulative distribution function
+    double *cdf = malloc(ranks * sizeof(double));
+    if (!cdf) {
+        return false;
+    }
+    double sum = 0;
+    for (size_t k = 0; k < ranks; k++) {
+        sum += 1.0 / (double) (k + 1);
+        cdf[k] = sum;
+    }
+    // Find the value of each element by binary search on the cumulative distribution function
+    for (size_t i = 0; i < n; ++i) {
+        double u = (double) rand() / ((double) RAND_MAX + 1) * sum;
+        size_t low = 0;
+        size_t high = ranks - 1;
+        while (low < high) {
+            size_t mid = low + (high - low) / 2;
+            if (cdf[mid] > u) {
+                high = mid;
+            } else {
+                low = mid + 1;
+            }
+        }
+        set_key(array, i, size, (int) low);
+    }
+    free(cdf);
+
+    return true;
+}
+
+/**
+ * Initialize an array with sorted values, and then swap random pairs of elements, so that about 5% of the elements
+ * are out of place.
+ *
+ * @param array The array to initialize.
+ * @param n The number of elements in the array.
+ * @param size The size in bytes of each element in the array.
+ * @param unique Not used.
+ * @return true.
+ */
+static bool init_array_nearly_sorted(void *array, size_t n, size_t size, int unique) {
+    init_array_sorted(array, n, size, unique);
+    for (size_t i = 0; i < n / 40; ++i) {
+        swap_keys(array, (size_t) rand() % n, (size_t) rand() % n, size);
+    }
+
+    return true;
+}
+
+/**
+ * Sort an array using merge sort, with one thread per online processor.
  *
- * @param sort The sort function to benchmark.
  * @param base A pointer to the first element of the array to be sorted.
  * @param n The number of elements in the array pointed by base.
  * @param size The size in bytes of each element in the array.
  * @param compare Pointer to a function that compares two elements.
- * @return The number of milliseconds that sorting took.
  */
-double benchmark_search(SORT_FUNC sort, void *array, size_t n, size_t size, COMPARE_FUNC compare) {
-    double start = get_time();
-    sort(array, n, size, compare);
-    double end = get_time();
+static void parallel_merge_sort_all(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    parallel_merge_sort(base, n, size, compare, 0);
+}
+
+/**
+ * Sort an array using quick sort, with one thread per online processor.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ */
+static void parallel_quick_sort_all(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    parallel_quick_sort(base, n, size, compare, 0);
+}
 
-    return end - start;
+/**
+ * Sort an array using tim sort, reporting when the temporary array cannot be allocated.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ */
+static void tim_sort_checked(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    if (!tim_sort(base, n, size, compare)) {
+        fprintf(stderr, "Cannot allocate memory.\n");
+    }
+}
+
+/**
+ * Returns the radix sort key of a record, which is its integer key with the sign bit flipped.
+ *
+ * @param item Pointer to the record.
+ * @return The radix sort key of the record.
+ */
+static uint64_t record_key(const void *item) {
+    int key;
+    memcpy(&key, item, sizeof(int));
+
+    return (unsigned int) key ^ (UINT_MAX ^ (UINT_MAX >> 1));
+}
+
+/**
+ * Sort an array using radix sort. Arrays of integers use the integer radix sort, and arrays of records use the radix
+ * sort on their integer key.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements, which is not used.
+ */
+static void radix_sort_records(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    (void) compare;
+    bool sorted = size == sizeof(int32_t) ? radix_sort_i32(base, n) : radix_sort_key(base, n, size, record_key);
+    if (!sorted) {
+        fprintf(stderr, "Cannot allocate memory.\n");
+    }
+}
+
+/**
+ * Sort an array indirectly: find the sorting permutation with arg sort, or with the key-prefix arg sort if a key
+ * prefix function is provided, and reorder the array by it.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ * @param prefix Pointer to a function that returns the key prefix of an element, or NULL.
+ */
+static void arg_sort_records(void *base, size_t n, size_t size, COMPARE_FUNC compare, KEY_FUNC prefix) {
+    size_t *perm = malloc(n * sizeof(size_t));
+    bool sorted = perm && (prefix ? arg_sort_prefix(perm, base, n, size, compare, prefix) :
+                                    arg_sort(perm, base, n, size, compare));
+    if (sorted) {
+        apply_permutation(base, perm, n, size);
+    } else {
+        fprintf(stderr, "Cannot allocate memory.\n");
+    }
+    free(perm);
+}
+
+/**
+ * Sort an array indirectly with arg sort.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ */
+static void arg_sort_all(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    arg_sort_records(base, n, size, compare, NULL);
+}
+
+/**
+ * Sort an array indirectly with the key-prefix arg sort, using the integer key of the records as the prefix.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ */
+static void arg_sort_prefix_all(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    arg_sort_records(base, n, size, compare, record_key);
+}
+
+/**
+ * Sort an array of integers using the typed quick sort, with the comparison inlined.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array, which must be the size of an integer.
+ * @param compare Pointer to a function that compares two elements, which is not used.
+ */
+static void typed_quick_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    (void) size;
+    (void) compare;
+    int_quick_sort(base, n);
+}
+
+/**
+ * Sort an array of integers using the typed merge sort, with the comparison inlined.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array, which must be the size of an integer.
+ * @param compare Pointer to a function that compares two elements, which is not used.
+ */
+static void typed_merge_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    (void) size;
+    (void) compare;
+    if (!int_merge_sort(base, n)) {
+        fprintf(stderr, "Cannot allocate memory.\n");
+    }
+}
+
+/**
+ * Sort an array of integers using the typed heap sort, with the comparison inlined.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array, which must be the size of an integer.
+ * @param compare Pointer to a function that compares two elements, which is not used.
+ */
+static void typed_heap_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    (void) size;
+    (void) compare;
+    int_heap_sort(base, n);
+}
+
+/**
+ * The typed sorts of an element type.
+ */
+typedef enum {
+    TYPED_QUICK,
+    TYPED_MERGE,
+    TYPED_HEAP
+} TypedSort;
+
+/**
+ * Define a function that sorts an array of an element type with one of its typed sorts.
+ *
+ * @param name The prefix of the names of the typed sorts.
+ * @param type The type of the elements.
+ */
+#define DEFINE_TYPED_DISPATCH(name, type) \
+    static bool name##_typed_sort(type *base, size_t n, TypedSort sort) { \
+        switch (sort) { \
+            case TYPED_QUICK: \
+                name##_quick_sort(base, n); \
+                return true; \
+            case TYPED_MERGE: \
+                return name##_merge_sort(base, n); \
+            case TYPED_HEAP: \
+                name##_heap_sort(base, n); \
+                return true; \
+        } \
+        return false; \
+    }
+
+DEFINE_TYPED_DISPATCH(long, long)
+DEFINE_TYPED_DISPATCH(double, double)
+DEFINE_TYPED_DISPATCH(uint64, uint64_t)
+DEFINE_TYPED_DISPATCH(string, const char *)
+
+/**
+ * Sort an array of records of the size of a double as doubles. The key of each record is converted in place to a
+ * double before the sort, and back after it, so the running time includes the conversions.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param sort The typed sort.
+ * @return true if the array was sorted, false if memory could not be allocated.
+ */
+static bool typed_sort_double(void *base, size_t n, TypedSort sort) {
+    double *values = base;
+    for (size_t i = 0; i < n; i++) {
+        int key;
+        memcpy(&key, &values[i], sizeof(int));
+        values[i] = key;
+    }
+    bool sorted = double_typed_sort(values, n, sort);
+    for (size_t i = 0; i < n; i++) {
+        int key = (int) values[i];
+        memset(&values[i], 0, sizeof(double));
+        memcpy(&values[i], &key, sizeof(int));
+    }
+
+    return sorted;
+}
+
+/**
+ * Sort an array of records of any size by sorting strings of their keys, padded with zeros so that the strings are in
+ * the order of the keys, which are not negative. The records are then placed in the order of their strings, so the
+ * running time includes the formatting and the placement.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param sort The typed sort.
+ * @return true if the array was sorted, false if memory could not be allocated.
+ */
+static bool typed_sort_string(void *base, size_t n, size_t size, TypedSort sort) {
+    char *strings = malloc(n * KEY_STRING_SIZE + 1);
+    const char **pointers = malloc(n * sizeof(const char *) + 1);
+    char *records = malloc(n * size + 1);
+    bool sorted = strings && pointers && records;
+    if (sorted) {
+        memcpy(records, base, n * size);
+        for (size_t i = 0; i < n; i++) {
+            int key;
+            memcpy(&key, records + i * size, sizeof(int));
+            snprintf(strings + i * KEY_STRING_SIZE, KEY_STRING_SIZE, "%010d", key);
+            pointers[i] = strings + i * KEY_STRING_SIZE;
+        }
+        sorted = string_typed_sort(pointers, n, sort);
+    }
+    for (size_t i = 0; sorted && i < n; i++) {
+        size_t index = (size_t) (pointers[i] - strings) / KEY_STRING_SIZE;
+        memcpy((char *) base + i * size, records + index * size, size);
+    }
+    free(strings);
+    free(pointers);
+    free(records);
+
+    return sorted;
+}
+
+/**
+ * Define the sort functions of the typed sorts of an element type, which report when memory cannot be allocated.
+ *
+ * @param name The name of the element type.
+ * @param call The call that sorts the array with the typed sort in the variable sort.
+ */
+#define DEFINE_TYPED_ALGORITHM(name, call) \
+    static void typed_##name(void *base, size_t n, size_t size, TypedSort sort) { \
+        (void) size; \
+        if (!(call)) { \
+            fprintf(stderr, "Cannot allocate memory.\n"); \
+        } \
+    } \
+    \
+    static void typed_##name##_quick_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) { \
+        (void) compare; \
+        typed_##name(base, n, size, TYPED_QUICK); \
+    } \
+    \
+    static void typed_##name##_merge_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) { \
+        (void) compare; \
+        typed_##name(base, n, size, TYPED_MERGE); \
+    } \
+    \
+    static void typed_##name##_heap_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) { \
+        (void) compare; \
+        typed_##name(base, n, size, TYPED_HEAP); \
+    }
+
+// The records of the size of a long integer and of 8 bytes are sorted as long and unsigned 64-bit integers, which
+// orders them by their key on little endian processors, since the keys are not negative and the padding is zero
+DEFINE_TYPED_ALGORITHM(long, long_typed_sort(base, n, sort))
+DEFINE_TYPED_ALGORITHM(uint64, uint64_typed_sort(base, n, sort))
+DEFINE_TYPED_ALGORITHM(double, typed_sort_double(base, n, sort))
+DEFINE_TYPED_ALGORITHM(string, typed_sort_string(base, n, size, sort))
+
+/**
+ * Sort an array of unsigned 64-bit integers using American flag sort. The records of 8 bytes are sorted as unsigned
+ * 64-bit integers, which orders them by their key on little endian processors, since the keys are not negative and the
+ * padding is zero.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array, which must be 8.
+ * @param compare Pointer to a function that compares two elements, which is not used.
+ */
+static void american_flag_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    (void) size;
+    (void) compare;
+    american_flag_sort_u64(base, n);
+}
+
+/**
+ * Sort an array of unsigned 64-bit integers using American flag sort, with one thread per online processor.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array, which must be 8.
+ * @param compare Pointer to a function that compares two elements, which is not used.
+ */
+static void parallel_american_flag_sort_all(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    (void) size;
+    (void) compare;
+    parallel_american_flag_sort_u64(base, n, 0);
+}
+
+/**
+ * Check if no element of a range is greater than an element, and no element of another range is less than it.
+ *
+ * @param base A pointer to the first element of the array.
+ * @param pivot The index of the element.
+ * @param low The index of the first element of the range before it.
+ * @param high The index after the last element of the range after it.
+ * @param size The size in bytes of each element in the array.
+ * @return true if the element separates the ranges.
+ */
+static bool is_partitioned(const void *base, size_t pivot, size_t low, size_t high, size_t size) {
+    const char *p = (const char *) base + pivot * size;
+    for (size_t i = low; i < high; i++) {
+        int order = compare_int((const char *) base + i * size, p);
+        if ((i < pivot && order > 0) || (i > pivot && order < 0)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Sort a range of an array by selecting its middle element with quick select, and sorting the parts before and after
+ * it in the same way.
+ *
+ * @param base A pointer to the first element of the array.
+ * @param low The index of the first element of the range.
+ * @param high The index after the last element of the range.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ */
+static void quick_select_range(void *base, size_t low, size_t high, size_t size, COMPARE_FUNC compare) {
+    while (high - low > 1) {
+        size_t mid = low + (high - low) / 2;
+        quick_select((char *) base + low * size, high - low, mid - low, size, compare);
+        if (checking && !is_partitioned(base, mid, low, high, size)) {
+            selection_failed = true;
+        }
+        // Recurse into the smaller part
+        if (mid - low < high - mid - 1) {
+            quick_select_range(base, low, mid, size, compare);
+            low = mid + 1;
+        } else {
+            quick_select_range(base, mid + 1, high, size, compare);
+            high = mid;
+        }
+    }
+}
+
+/**
+ * Sort an array with quick select, by selecting the middle element of each range. Each selection is checked to
+ * partition its range in the checked run.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ */
+static void quick_select_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    quick_select_range(base, 0, n, size, compare);
+}
+
+/**
+ * Sort an array with partial sort: the smallest half of the elements are sorted to its start, and then the rest of the
+ * elements are sorted by a partial sort with a bigger k than their number. In the checked run the sorted half is
+ * checked to not be greater than the rest.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ */
+static void partial_sort_halves(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    size_t k = n / 2;
+    partial_sort(base, n, k, size, compare);
+    if (checking && k > 0 && !is_partitioned(base, k - 1, k - 1, n, size)) {
+        selection_failed = true;
+    }
+    partial_sort((char *) base + k * size, n - k, n + 1, size, compare);
+}
+
+/**
+ * Sort an array with top k, by copying the smallest n + 1 elements, which are all of them. In the checked run the
+ * smallest half of the elements and none of them are copied as well, and the results are checked against the sorted
+ * array.
+ *
+ * @param base A pointer to the first element of the array to be sorted.
+ * @param n The number of elements in the array pointed by base.
+ * @param size The size in bytes of each element in the array.
+ * @param compare Pointer to a function that compares two elements.
+ */
+static void top_k_sort(void *base, size_t n, size_t size, COMPARE_FUNC compare) {
+    char *dest = malloc((n + n / 2 + 1) * size);
+    if (!dest) {
+        fprintf(stderr, "Cannot allocate memory.\n");
+        return;
+    }
+    if (top_k(dest, base, n, n + 1, size, compare) != n) {
+        selection_failed = true;
+    }
+    if (checking) {
+        char *half = dest + n * size;
+        if (top_k(half, base, n, n / 2, size, compare) != n / 2 || memcmp(half, dest, n / 2 * size) != 0 ||
+            top_k(half, base, n, 0, size, compare) != 0) {
+            selection_failed = true;
+        }
+    }
+    memcpy(base, dest, n * size);
+    free(dest);
+}
+
+// The algorithms that can be benchmarked
+static const Algorithm algorithms[] = {
+    {"insertion", insertion_sort, ALGORITHM_QUADRATIC},
+    {"bubble", bubble_sort, ALGORITHM_QUADRATIC},
+    {"selection", selection_sort, ALGORITHM_QUADRATIC},
+    {"shell", shell_sort, 0},
+    {"merge", merge_sort, 0},
+    {"in-place-merge", in_place_merge_sort, 0},
+    {"parallel-merge", parallel_merge_sort_all, 0},
+    {"heap", heap_sort, 0},
+    {"smooth", smooth_sort, 0},
+    {"quick", quick_sort, 0},
+    {"quick-3way", quick_sort_3way, 0},
+    {"parallel-quick", parallel_quick_sort_all, 0},
+    {"pdq", pdq_sort, 0},
+    {"tim", tim_sort_checked, 0},
+    {"radix", radix_sort_records, 0},
+    {"american-flag", american_flag_sort, ALGORITHM_U64},
+    {"parallel-american-flag", parallel_american_flag_sort_all, ALGORITHM_U64},
+    {"arg", arg_sort_all, 0},
+    {"arg-prefix", arg_sort_prefix_all, 0},
+    {"quick-select", quick_select_sort, 0},
+    {"partial", partial_sort_halves, 0},
+    {"top-k", top_k_sort, 0},
+    {"typed-quick", typed_quick_sort, ALGORITHM_INT},
+    {"typed-merge", typed_merge_sort, ALGORITHM_INT},
+    {"typed-heap", typed_heap_sort, ALGORITHM_INT},
+    {"typed-long-quick", typed_long_quick_sort, ALGORITHM_LONG},
+    {"typed-long-merge", typed_long_merge_sort, ALGORITHM_LONG},
+    {"typed-long-heap", typed_long_heap_sort, ALGORITHM_LONG},
+    {"typed-double-quick", typed_double_quick_sort, ALGORITHM_DOUBLE},
+    {"typed-double-merge", typed_double_merge_sort, ALGORITHM_DOUBLE},
+    {"typed-double-heap", typed_double_heap_sort, ALGORITHM_DOUBLE},
+    {"typed-uint64-quick", typed_uint64_quick_sort, ALGORITHM_U64},
+    {"typed-uint64-merge", typed_uint64_merge_sort, ALGORITHM_U64},
+    {"typed-uint64-heap", typed_uint64_heap_sort, ALGORITHM_U64},
+    {"typed-string-quick", typed_string_quick_sort, 0},
+    {"typed-string-merge", typed_string_merge_sort, 0},
+    {"typed-string-heap", typed_string_heap_sort, 0}
+};
+
+// The number of algorithms
+#define NUM_ALGORITHMS (sizeof(algorithms) / sizeof(algorithms[0]))
+
+// The input distributions
+static const Distribution distributions[] = {
+    {"random", init_array_random},
+    {"sorted", init_array_sorted},
+    {"reversed", init_array_reversed},
+    {"organ-pipe", init_array_organ_pipe},
+    {"few-unique", init_array_few_unique},
+    {"sawtooth", init_array_sawtooth},
+    {"zipf", init_array_zipf},
+    {"nearly-sorted", init_array_nearly_sorted}
+};
+
+// The number of input distributions
+#define NUM_DISTRIBUTIONS (sizeof(distributions) / sizeof(distributions[0]))
+
+/**
+ * Select the items of a comma separated list of names, or all the items if the list is "all".
+ *
+ * @param list The comma separated list. It is modified.
+ * @param names The names of the items, each one in the first member of a structure.
+ * @param count The number of items.
+ * @param stride The size in bytes of the structures.
+ * @param selected Set to true for each selected item.
+ * @param named Set to true for each item that was selected by name, if not NULL.
+ * @return true if all names are valid, false otherwise.
+ */
+static bool select_names(char *list, const void *names, size_t count, size_t stride, bool *selected, bool *named) {
+    for (char *name = strtok(list, ","); name; name = strtok(NULL, ",")) {
+        bool all = strcmp(name, "all") == 0;
+        bool found = all;
+        for (size_t i = 0; i < count; i++) {
+            const char *item = *((const char * const *) ((const char *) names + i * stride));
+            if (all || strcmp(name, item) == 0) {
+                selected[i] = true;
+                if (named && !all) {
+                    named[i] = true;
+                }
+                found = true;
+            }
+        }
+        if (!found) {
+            fprintf(stderr, "Invalid name: %s\n", name);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Parse a comma separated list of element sizes, or all the benchmarked sizes if the list is "all".
+ *
+ * @param list The comma separated list. It is modified.
+ * @param sizes The array where the sizes are stored, with room for MAX_ELEMENT_SIZES sizes.
+ * @return The number of sizes, or zero if the list is invalid.
+ */
+static size_t parse_sizes(char *list, size_t *sizes) {
+    static const size_t all_sizes[] = {4, 8, 16, 64, 256};
+    size_t count = 0;
+    for (char *token = strtok(list, ","); token; token = strtok(NULL, ",")) {
+        if (strcmp(token, "all") == 0) {
+            for (size_t i = 0; i < sizeof(all_sizes) / sizeof(all_sizes[0]) && count < MAX_ELEMENT_SIZES; i++) {
+                sizes[count++] = all_sizes[i];
+            }
+            continue;
+        }
+        size_t size = (size_t) atoi(token);
+        if (size < sizeof(int) || size % sizeof(int) != 0) {
+            fprintf(stderr, "The element size must be a positive multiple of %zu.\n", sizeof(int));
+            return 0;
+        }
+        if (count == MAX_ELEMENT_SIZES) {
+            fprintf(stderr, "At most %d element sizes can be benchmarked.\n", MAX_ELEMENT_SIZES);
+            return 0;
+        }
+        sizes[count++] = size;
+    }
+
+    return count;
+}
+
+/**
+ * Check if an algorithm can sort an array.
+ *
+ * @param algorithm The algorithm.
+ * @param n The number of elements in the array.
+ * @param size The size in bytes of each element in the array.
+ * @param named true if the algorithm was selected by name.
+ * @return true if the algorithm can sort the array.
+ */
+static bool algorithm_applies(const Algorithm *algorithm, size_t n, size_t size, bool named) {
+    if ((algorithm->flags & ALGORITHM_INT) && size != sizeof(int)) {
+        return false;
+    }
+    if ((algorithm->flags & ALGORITHM_U64) && size != sizeof(uint64_t)) {
+        return false;
+    }
+    if ((algorithm->flags & ALGORITHM_LONG) && size != sizeof(long)) {
+        return false;
+    }
+    if ((algorithm->flags & ALGORITHM_DOUBLE) && size != sizeof(double)) {
+        return false;
+    }
+
+    return named || !(algorithm->flags & ALGORITHM_QUADRATIC) || n <= QUADRATIC_LIMIT;
+}
+
+/**
+ * Benchmark a sort function. The comparisons are counted in a first run, which is not timed, and its result is compared
+ * to the input sorted by qsort, so that the elements that are lost or duplicated are caught as well as the ones out of
+ * order. Then the warmup and the timed runs follow. Every run sorts a copy of the input array. The first run also
+ * collects the statistics of the sort, which are zero unless the library is built with the SORT_STATS option.
+ *
+ * @param sort The sort function to benchmark.
+ * @param input The input array.
+ * @param expected The input array sorted by qsort. The elements with equal keys are equal, so it is the only sorted
+ * permutation of the input.
+ * @param array The array to sort, with room for the elements of the input array.
+ * @param n The number of elements in the array.
+ * @param size The size in bytes of each element in the array.
+ * @param warmup The number of warmup runs.
+ * @param times The array where the running times are stored, with room for one time per timed run.
+ * @param runs The number of timed runs.
+ * @param result The results of the benchmark.
+ */
+static void benchmark_sort(SORT_FUNC sort, const void *input, const void *expected, void *array, size_t n, size_t size,
+                           size_t warmup, double *times, size_t runs, Result *result) {
+    // Count the comparisons and check the result
+    memcpy(array, input, n * size);
+    atomic_store(&comparisons, 0);
+    checking = true;
+    selection_failed = false;
+    sort_stats_begin(&result->stats);
+    sort(array, n, size, compare_int_counting);
+    sort_stats_end();
+    checking = false;
+    result->comparisons = atomic_load(&comparisons);
+    result->sorted = !selection_failed && (n == 0 || memcmp(array, expected, n * size) == 0);
+    // Warm up the caches and the branch predictors
+    for (size_t i = 0; i < warmup; i++) {
+        memcpy(array, input, n * size);
+        sort(array, n, size, compare_int);
+    }
+    // Time the runs
+    for (size_t i = 0; i < runs; i++) {
+        memcpy(array, input, n * size);
+        double start = get_time();
+        sort(array, n, size, compare_int);
+        times[i] = get_time() - start;
+    }
+    qsort(times, runs, sizeof(double), compare_double);
+    result->min = times[0];
+    result->median = runs % 2 == 1 ? times[runs / 2] : (times[runs / 2 - 1] + times[runs / 2]) / 2;
+    result->p95 = times[(runs * 95 + 99) / 100 - 1];
+}
+
+/**
+ * Print the header of the results.
+ *
+ * @param format The output format.
+ */
+static void print_header(Format format) {
+    switch (format) {
+        case FORMAT_TEXT:
+            printf("%-24s %-14s %10s %5s %12s %12s %12s %14s %14s %14s %12s %5s %s\n", "algorithm", "distribution", "n",
+                   "size", "min", "median", "p95", "comparisons", "moves", "swaps", "aux_bytes", "depth", "sorted");
+            break;
+        case FORMAT_CSV:
+            printf("algorithm,distribution,n,element_size,runs,min,median,p95,comparisons,moves,swaps,aux_bytes,"
+                   "max_depth,sorted\n");
+            break;
+        case FORMAT_JSON:
+            printf("[");
+            break;
+    }
+}
+
+/**
+ * Print the results of a benchmark.
+ *
+ * @param format The output format.
+ * @param first true if these are the first results that are printed.
+ * @param algorithm The name of the algorithm.
+ * @param distribution The name of the input distribution.
+ * @param n The number of elements in the array.
+ * @param size The size in bytes of each element in the array.
+ * @param runs The number of timed runs.
+ * @param result The results.
+ */
+static void print_result(Format format, bool first, const char *algorithm, const char *distribution, size_t n,
+                         size_t size, size_t runs, const Result *result) {
+    switch (format) {
+        case FORMAT_TEXT:
+            printf("%-24s %-14s %10zu %5zu %12.6f %12.6f %12.6f %14llu %14llu %14llu %12llu %5llu %s\n", algorithm,
+                   distribution, n, size, result->min, result->median, result->p95, result->comparisons,
+                   (unsigned long long) result->stats.moves, (unsigned long long) result->stats.swaps,
+                   (unsigned long long) result->stats.aux_bytes, (unsigned long long) result->stats.max_depth,
+                   result->sorted ? "yes" : "NO");
+            break;
+        case FORMAT_CSV:
+            printf("%s,%s,%zu,%zu,%zu,%.9f,%.9f,%.9f,%llu,%llu,%llu,%llu,%llu,%s\n", algorithm, distribution, n, size,
+                   runs, result->min, result->median, result->p95, result->comparisons,
+                   (unsigned long long) result->stats.moves, (unsigned long long) result->stats.swaps,
+                   (unsigned long long) result->stats.aux_bytes, (unsigned long long) result->stats.max_depth,
+                   result->sorted ? "true" : "false");
+            break;
+        case FORMAT_JSON:
+            printf("%s\n  {\"algorithm\": \"%s\", \"distribution\": \"%s\", \"n\": %zu, \"element_size\": %zu, "
+                   "\"runs\": %zu, \"min\": %.9f, \"median\": %.9f, \"p95\": %.9f, \"comparisons\": %llu, "
+                   "\"moves\": %llu, \"swaps\": %llu, \"aux_bytes\": %llu, \"max_depth\": %llu, \"sorted\": %s}",
+                   first ? "" : ",", algorithm, distribution, n, size, runs, result->min, result->median, result->p95,
+                   result->comparisons, (unsigned long long) result->stats.moves,
+                   (unsigned long long) result->stats.swaps, (unsigned long long) result->stats.aux_bytes,
+                   (unsigned long long) result->stats.max_depth, result->sorted ? "true" : "false");
+            break;
+    }
+    fflush(stdout);
+}
+
+/**
+ * Print the footer of the results.
+ *
+ * @param format The output format.
+ */
+static void print_footer(Format format) {
+    if (format == FORMAT_JSON) {
+        printf("\n]\n");
+    }
 }
 
 int main(int argc, char **argv) {
     static struct option long_options[] = {
         {"algorithm", required_argument, 0, 'a'},
+        {"distribution", required_argument, 0, 'd'},
         {"num", required_argument, 0, 'n'},
+        {"element-size", required_argument, 0, 's'},
+        {"unique", required_argument, 0, 'u'},
+        {"runs", required_argument, 0, 'r'},
+        {"warmup", required_argument, 0, 'w'},
+        {"format", required_argument, 0, 'f'},
+        {"seed", required_argument, 0, 'S'},
         {0, 0, 0, 0}
     };
     int option_index = 0;
     int c;
-    SORT_FUNC sort = NULL;
-    size_t num_elements = 0;
-    while ((c = getopt_long(argc, argv, "a:n:", long_options, &option_index)) != -1) {
+    bool selected_algorithms[NUM_ALGORITHMS] = {false};
+    bool named_algorithms[NUM_ALGORITHMS] = {false};
+    bool selected_distributions[NUM_DISTRIBUTIONS] = {false};
+    bool distribution_given = false;
+    size_t num_elements = DEFAULT_NUM_ELEMENTS;
+    size_t element_sizes[MAX_ELEMENT_SIZES] = {sizeof(int)};
+    size_t num_sizes = 1;
+    int unique = 0;
+    size_t runs = DEFAULT_RUNS;
+    size_t warmup = DEFAULT_WARMUP;
+    Format format = FORMAT_TEXT;
+    unsigned seed = 1;
+    while ((c = getopt_long(argc, argv, "a:d:n:s:u:r:w:f:S:", long_options, &option_index)) != -1) {
         switch(c) {
             case 'a':
-                if (strcmp(optarg, "insertion") == 0) {
-                    sort = insertion_sort;
-                } else if (strcmp(optarg, "bubble") == 0) {
-                    sort = bubble_sort;
-                } else if (strcmp(optarg, "selection") == 0) {
-                    sort = selection_sort;
-                } else if (strcmp(optarg, "shell") == 0) {
-                    sort = shell_sort;
-                } else if (strcmp(optarg, "merge") == 0) {
-                    sort = merge_sort;
-                } else if (strcmp(optarg, "quick") == 0) {
-                    sort = quick_sort;
-                } else {
-                    fprintf(stderr, "Invalid sorting algorithm: %s\n", optarg);
+                if (!select_names(optarg, algorithms, NUM_ALGORITHMS, sizeof(Algorithm), selected_algorithms,
+                                  named_algorithms)) {
                     return EXIT_FAILURE;
                 }
                 break;
+            case 'd':
+                if (!select_names(optarg, distributions, NUM_DISTRIBUTIONS, sizeof(Distribution),
+                                  selected_distributions, NULL)) {
+                    return EXIT_FAILURE;
+                }
+                distribution_given = true;
+                break;
             case 'n':
-                num_elements = (size_t) atoi(optarg);
-                if (num_elements < 0) {
-                    fprintf(stderr, "The number of elements to sort must be "
-                                    "positive.");
+                num_elements = (size_t) atol(optarg);
+                if (num_elements > INT_MAX) {
+                    fprintf(stderr, "The number of elements to sort must be at most %d.\n", INT_MAX);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 's':
+                num_sizes = parse_sizes(optarg, element_sizes);
+                if (num_sizes == 0) {
                     return EXIT_FAILURE;
                 }
                 break;
+            case 'u':
+                unique = atoi(optarg);
+                if (unique <= 0) {
+                    fprintf(stderr, "The number of distinct values must be positive.\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'r':
+                runs = (size_t) atol(optarg);
+                if (runs == 0) {
+                    fprintf(stderr, "The number of runs must be positive.\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'w':
+                warmup = (size_t) atol(optarg);
+                break;
+            case 'f':
+                if (strcmp(optarg, "text") == 0) {
+                    format = FORMAT_TEXT;
+                } else if (strcmp(optarg, "csv") == 0) {
+                    format = FORMAT_CSV;
+                } else if (strcmp(optarg, "json") == 0) {
+                    format = FORMAT_JSON;
+                } else {
+                    fprintf(stderr, "Invalid output format: %s\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'S':
+                seed = (unsigned) atol(optarg);
+                break;
             default:
-                printf("c: %c", c);
-                continue;
+                fprintf(stderr, "Invalid option: %c\n", c);
+                return EXIT_FAILURE;
         }
     }
+    // Benchmark all the algorithms that are not quadratic by default
+    bool algorithm_given = false;
+    for (size_t a = 0; a < NUM_ALGORITHMS; a++) {
+        algorithm_given = algorithm_given || selected_algorithms[a];
+    }
+    for (size_t a = 0; a < NUM_ALGORITHMS && !algorithm_given; a++) {
+        selected_algorithms[a] = !(algorithms[a].flags & ALGORITHM_QUADRATIC);
+    }
+    // Benchmark the random distribution by default, or the few unique one if the number of distinct values is given
+    if (!distribution_given) {
+        char name[] = "random";
+        char few_unique_name[] = "few-unique";
+        select_names(unique > 0 ? few_unique_name : name, distributions, NUM_DISTRIBUTIONS, sizeof(Distribution),
+                     selected_distributions, NULL);
+    }
+    if (unique == 0) {
+        unique = DEFAULT_UNIQUE;
+    }
 
-    // Perform sorting and print the running time
-    srand(time(NULL));
-    void *array = malloc(num_elements * sizeof(int));
-    if (!array) {
+    // Allocate the arrays for the largest element size
+    size_t max_size = 0;
+    for (size_t i = 0; i < num_sizes; i++) {
+        max_size = element_sizes[i] > max_size ? element_sizes[i] : max_size;
+    }
+    void *input = calloc(num_elements, max_size);
+    void *expected = malloc(num_elements * max_size);
+    void *array = malloc(num_elements * max_size);
+    double *times = malloc(runs * sizeof(double));
+    if (!input || !expected || !array || !times) {
         fprintf(stderr, "Cannot allocate memory.\n");
+        free(input);
+        free(expected);
+        free(array);
+        free(times);
         return EXIT_FAILURE;
     }
 
-    init_int_array_random(array, num_elements);
-    printf("Testing sort for random array of size %zu\n", num_elements);
-    double elapsed = benchmark_search(sort, array, num_elements, sizeof(int), compare_int);
-    printf("Total time: %.3f\n", elapsed);
+    // Run the benchmarks
+    int return_val = EXIT_SUCCESS;
+    bool first = true;
+    print_header(format);
+    for (size_t s = 0; s < num_sizes; s++) {
+        size_t size = element_sizes[s];
+        for (size_t a = 0; a < NUM_ALGORITHMS; a++) {
+            if (named_algorithms[a] && !algorithm_applies(&algorithms[a], num_elements, size, true)) {
+                fprintf(stderr, "Skipping %s for elements of %zu bytes.\n", algorithms[a].name, size);
+            }
+        }
+        for (size_t d = 0; d < NUM_DISTRIBUTIONS; d++) {
+            if (!selected_distributions[d]) {
+                continue;
+            }
+            // Every algorithm sorts the same input
+            srand(seed);
+            memset(input, 0, num_elements * size);
+            if (!distributions[d].init(input, num_elements, size, unique)) {
+                fprintf(stderr, "Cannot allocate memory.\n");
+                return_val = EXIT_FAILURE;
+                continue;
+            }
+            memcpy(expected, input, num_elements * size);
+            qsort(expected, num_elements, size, compare_int);
+            for (size_t a = 0; a < NUM_ALGORITHMS; a++) {
+                if (!selected_algorithms[a] ||
+                    !algorithm_applies(&algorithms[a], num_elements, size, named_algorithms[a])) {
+                    continue;
+                }
+                Result result;
+                benchmark_sort(algorithms[a].sort, input, expected, array, num_elements, size, warmup, times, runs,
+                               &result);
+                print_result(format, first, algorithms[a].name, distributions[d].name, num_elements, size, runs,
+                             &result);
+                first = false;
+                if (!result.sorted) {
+                    return_val = EXIT_FAILURE;
+                }
+            }
+        }
+    }
+    print_footer(format);
 
     // Free memory
+    free(input);
+    free(expected);
     free(array);
+    free(times);
 
-    return EXIT_SUCCESS;
+    return return_val;
 }